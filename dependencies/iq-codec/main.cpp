@@ -0,0 +1,335 @@
+// Lossless codec for cs16 IQ recordings (interleaved little-endian int16 I and Q, as stored by exp202).
+// Every block of 4096 samples is coded on its own: I and Q each get the fixed linear predictor (order 0, 1 or 2)
+// with the smallest residuals, and the zigzagged residuals are Rice coded with a parameter picked for every 256 of
+// them. A block that would not get smaller is stored raw, so the output grows by at most 9 bytes per block.
+// Usage: iq_codec < recording.cs16 > recording.iqc
+//        iq_codec -d < recording.iqc > recording.cs16
+// Build: see dependencies/sepp_build/build-iq-tools.sh, the prediction uses NEON when built for the SEPP.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+const char magic[4] = {'I', 'Q', 'C', '1'};
+const int block_samples = 4096;
+const int partition_samples = 256;
+const int max_order = 2;
+const int max_rice = 20;
+const int escape_quotient = 24; // longer quotients are written as the whole residual in 32 bits
+
+const uint8_t mode_raw = 0;
+const uint8_t mode_coded = 1;
+
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int bits = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& buffer) : out(buffer) {}
+
+    // n <= 32, value < 2^n
+    void put(uint32_t value, int n) {
+        acc = (acc << n) | value;
+        bits += n;
+        while (bits >= 8) {
+            bits -= 8;
+            out.push_back(uint8_t(acc >> bits));
+        }
+    }
+
+    void rice(uint32_t u, int k) {
+        uint32_t q = u >> k;
+        if (q < uint32_t(escape_quotient)) {
+            put((2u << q) - 2, q + 1); // q ones and a zero
+            put(u & ((1u << k) - 1), k);
+        } else {
+            put((1u << escape_quotient) - 1, escape_quotient);
+            put(u, 32);
+        }
+    }
+
+    void flush() {
+        if (bits > 0) {
+            out.push_back(uint8_t(acc << (8 - bits)));
+        }
+        bits = 0;
+    }
+};
+
+struct BitReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t acc = 0;
+    int bits = 0;
+
+    BitReader(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+    void fill() {
+        while (bits <= 56) {
+            acc = (acc << 8) | (p < end ? *p++ : 0);
+            bits += 8;
+        }
+    }
+
+    uint32_t get(int n) {
+        if (n == 0) {
+            return 0;
+        }
+        fill();
+        bits -= n;
+        return uint32_t(acc >> bits) & uint32_t((1ull << n) - 1);
+    }
+
+    uint32_t rice(int k) {
+        fill();
+        uint64_t window = ~(acc << (64 - bits));
+        int ones = window ? __builtin_clzll(window) : 64;
+        if (ones >= escape_quotient) {
+            bits -= escape_quotient;
+            return get(32);
+        }
+        bits -= ones + 1;
+        return (uint32_t(ones) << k) | get(k);
+    }
+};
+
+static inline uint32_t zigzag(int32_t r) {
+    return (uint32_t(r) << 1) ^ uint32_t(r >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u) {
+    return int32_t(u >> 1) ^ -int32_t(u & 1);
+}
+
+// Prediction of x[i] from the samples before it, zeros before the block
+static inline int32_t prediction(const int16_t* x, int i, int order) {
+    int32_t x1 = i >= 1 ? x[i - 1] : 0;
+    int32_t x2 = i >= 2 ? x[i - 2] : 0;
+    if (order == 0) {
+        return 0;
+    }
+    return order == 1 ? x1 : 2 * x1 - x2;
+}
+
+// Zigzagged residuals of the predictor of the given order into u, returns their sum
+static uint64_t predict(const int16_t* x, int n, int order, uint32_t* u) {
+    uint64_t sum = 0;
+    int i = 0;
+    for (; i < n && i < max_order; i++) {
+        u[i] = zigzag(x[i] - prediction(x, i, order));
+        sum += u[i];
+    }
+#ifdef __ARM_NEON
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x0 = vld1q_s16(x + i);
+        int32x4_t lo = vmovl_s16(vget_low_s16(x0));
+        int32x4_t hi = vmovl_s16(vget_high_s16(x0));
+        if (order >= 1) {
+            int16x8_t x1 = vld1q_s16(x + i - 1);
+            int32x4_t lo1 = vmovl_s16(vget_low_s16(x1));
+            int32x4_t hi1 = vmovl_s16(vget_high_s16(x1));
+            if (order == 2) {
+                int16x8_t x2 = vld1q_s16(x + i - 2);
+                lo = vaddq_s32(lo, vmovl_s16(vget_low_s16(x2)));
+                hi = vaddq_s32(hi, vmovl_s16(vget_high_s16(x2)));
+                lo1 = vshlq_n_s32(lo1, 1);
+                hi1 = vshlq_n_s32(hi1, 1);
+            }
+            lo = vsubq_s32(lo, lo1);
+            hi = vsubq_s32(hi, hi1);
+        }
+        uint32x4_t zlo = vreinterpretq_u32_s32(veorq_s32(vshlq_n_s32(lo, 1), vshrq_n_s32(lo, 31)));
+        uint32x4_t zhi = vreinterpretq_u32_s32(veorq_s32(vshlq_n_s32(hi, 1), vshrq_n_s32(hi, 31)));
+        vst1q_u32(u + i, zlo);
+        vst1q_u32(u + i + 4, zhi);
+        acc = vpadalq_u32(acc, zlo);
+        acc = vpadalq_u32(acc, zhi);
+    }
+    sum += vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    for (; i < n; i++) {
+        u[i] = zigzag(x[i] - prediction(x, i, order));
+        sum += u[i];
+    }
+    return sum;
+}
+
+// Split interleaved samples into I and Q
+static void deinterleave(const int16_t* iq, int n, int16_t* i_out, int16_t* q_out) {
+    int s = 0;
+#ifdef __ARM_NEON
+    for (; s + 8 <= n; s += 8) {
+        int16x8x2_t v = vld2q_s16(iq + 2 * s);
+        vst1q_s16(i_out + s, v.val[0]);
+        vst1q_s16(q_out + s, v.val[1]);
+    }
+#endif
+    for (; s < n; s++) {
+        i_out[s] = iq[2 * s];
+        q_out[s] = iq[2 * s + 1];
+    }
+}
+
+static void encode_channel(BitWriter& writer, const int16_t* x, int n, uint32_t* u, uint32_t* best) {
+    int order = 0;
+    uint64_t best_sum = predict(x, n, 0, best);
+    for (int candidate = 1; candidate <= max_order; candidate++) {
+        uint64_t sum = predict(x, n, candidate, u);
+        if (sum < best_sum) {
+            best_sum = sum;
+            order = candidate;
+            std::memcpy(best, u, n * sizeof(uint32_t));
+        }
+    }
+    writer.put(order, 2);
+
+    for (int start = 0; start < n; start += partition_samples) {
+        int count = n - start < partition_samples ? n - start : partition_samples;
+        uint64_t sum = 0;
+        for (int i = start; i < start + count; i++) {
+            sum += best[i];
+        }
+        // 2^k close to the mean residual
+        int k = 0;
+        while (k < max_rice && (uint64_t(count) << (k + 1)) <= sum) {
+            k++;
+        }
+        writer.put(k, 5);
+        for (int i = start; i < start + count; i++) {
+            writer.rice(best[i], k);
+        }
+    }
+}
+
+static void decode_channel(BitReader& reader, int16_t* x, int n) {
+    int order = reader.get(2);
+    for (int start = 0; start < n; start += partition_samples) {
+        int count = n - start < partition_samples ? n - start : partition_samples;
+        int k = reader.get(5);
+        for (int i = start; i < start + count; i++) {
+            x[i] = int16_t(unzigzag(reader.rice(k)) + prediction(x, i, order));
+        }
+    }
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(uint8_t(value >> (8 * i)));
+    }
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (uint32_t(in[3]) << 24);
+}
+
+// Block: raw bytes (u32), payload bytes (u32), mode (u8), payload
+static void write_block(const uint8_t* raw, uint32_t raw_bytes, const std::vector<uint8_t>& coded) {
+    std::vector<uint8_t> header;
+    bool use_coded = !coded.empty() && coded.size() < raw_bytes;
+    put_u32(header, raw_bytes);
+    put_u32(header, use_coded ? coded.size() : raw_bytes);
+    header.push_back(use_coded ? mode_coded : mode_raw);
+    fwrite(header.data(), 1, header.size(), stdout);
+    if (use_coded) {
+        fwrite(coded.data(), 1, coded.size(), stdout);
+    } else {
+        fwrite(raw, 1, raw_bytes, stdout);
+    }
+}
+
+int compress() {
+    std::vector<uint8_t> raw(block_samples * 4);
+    std::vector<int16_t> iq(block_samples * 2), i_samples(block_samples), q_samples(block_samples);
+    std::vector<uint32_t> u(block_samples), best(block_samples);
+    std::vector<uint8_t> coded;
+
+    fwrite(magic, 1, sizeof(magic), stdout);
+    size_t got;
+    while ((got = fread(raw.data(), 1, raw.size(), stdin)) > 0) {
+        int n = got / 4;
+        if (n > 0) {
+            // Samples are little endian, as is the SEPP
+            std::memcpy(iq.data(), raw.data(), n * 4);
+            deinterleave(iq.data(), n, i_samples.data(), q_samples.data());
+            coded.clear();
+            BitWriter writer(coded);
+            encode_channel(writer, i_samples.data(), n, u.data(), best.data());
+            encode_channel(writer, q_samples.data(), n, u.data(), best.data());
+            writer.flush();
+            write_block(raw.data(), n * 4, coded);
+        }
+        // A trailing partial sample is kept as it is
+        if (got % 4) {
+            write_block(raw.data() + n * 4, got % 4, std::vector<uint8_t>());
+        }
+    }
+    if (ferror(stdin) || ferror(stdout)) {
+        std::cerr << "iq_codec: read or write error" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int decompress() {
+    std::vector<uint8_t> payload;
+    std::vector<int16_t> iq(block_samples * 2), i_samples(block_samples), q_samples(block_samples);
+    uint8_t header[9];
+
+    if (fread(header, 1, sizeof(magic), stdin) != sizeof(magic) || std::memcmp(header, magic, sizeof(magic)) != 0) {
+        std::cerr << "iq_codec: not an iq_codec stream" << std::endl;
+        return 1;
+    }
+    while (fread(header, 1, sizeof(header), stdin) == sizeof(header)) {
+        uint32_t raw_bytes = get_u32(header);
+        uint32_t payload_bytes = get_u32(header + 4);
+        uint8_t mode = header[8];
+        if (raw_bytes > uint32_t(block_samples * 4) || payload_bytes > raw_bytes || (mode == mode_coded && raw_bytes % 4)) {
+            std::cerr << "iq_codec: damaged block header" << std::endl;
+            return 1;
+        }
+        payload.resize(payload_bytes);
+        if (fread(payload.data(), 1, payload_bytes, stdin) != payload_bytes) {
+            std::cerr << "iq_codec: truncated block" << std::endl;
+            return 1;
+        }
+        if (mode == mode_raw) {
+            fwrite(payload.data(), 1, payload_bytes, stdout);
+            continue;
+        }
+        int n = raw_bytes / 4;
+        BitReader reader(payload.data(), payload.size());
+        decode_channel(reader, i_samples.data(), n);
+        decode_channel(reader, q_samples.data(), n);
+        for (int s = 0; s < n; s++) {
+            iq[2 * s] = i_samples[s];
+            iq[2 * s + 1] = q_samples[s];
+        }
+        fwrite(iq.data(), 1, raw_bytes, stdout);
+    }
+    if (ferror(stdin) || ferror(stdout)) {
+        std::cerr << "iq_codec: read or write error" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    static char in_buffer[1 << 20], out_buffer[1 << 20];
+    setvbuf(stdin, in_buffer, _IOFBF, sizeof(in_buffer));
+    setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+
+    if (argc > 1 && std::strcmp(argv[1], "-d") == 0) {
+        return decompress();
+    }
+    if (argc > 1) {
+        std::cerr << "Usage: " << argv[0] << " [-d] < input > output" << std::endl;
+        return 1;
+    }
+    return compress();
+}
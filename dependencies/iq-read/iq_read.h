@@ -0,0 +1,69 @@
+// Byte range reader for recordings on the eMMC (or an image of P180), without tar in between.
+// The range is read with 1 MiB preads aligned to 1 MiB of the device, the kernel is told the access is sequential so
+// its readahead keeps the next blocks coming while the caller works on the last ones.
+// Include it and call iq_read::read_range, or use the iq_read tool (main.cpp) from the shell.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace iq_read {
+
+const uint64_t read_size = 1 << 20;
+const uint64_t sample_size = 4; // cs16, interleaved int16 I and Q
+
+// Gets every piece of the range in order, returns false to stop reading
+using Sink = std::function<bool(const char* data, size_t bytes)>;
+
+// Passes bytes [offset, offset + length) of fd to sink. Returns 0, or the errno of the read that failed.
+// A range past the end of the device stops at its end.
+inline int read_range(int fd, uint64_t offset, uint64_t length, const Sink& sink) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, 4096, read_size) != 0) {
+        return ENOMEM;
+    }
+    posix_fadvise(fd, offset, length, POSIX_FADV_SEQUENTIAL);
+
+    int status = 0;
+    uint64_t position = offset - offset % read_size;
+    uint64_t end = offset + length;
+    while (position < end) {
+        ssize_t got = pread(fd, buffer, read_size, position);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            status = got < 0 ? errno : 0;
+            break;
+        }
+        uint64_t from = offset > position ? offset - position : 0;
+        uint64_t to = end - position < uint64_t(got) ? end - position : uint64_t(got);
+        if (from < to && !sink(static_cast<const char*>(buffer) + from, to - from)) {
+            break;
+        }
+        position += got;
+    }
+    std::free(buffer);
+    return status;
+}
+
+// Samples [sample_offset, sample_offset + sample_count) of the payload at payload_offset, payload_bytes long
+inline int read_samples(int fd, uint64_t payload_offset, uint64_t payload_bytes, uint64_t sample_offset, uint64_t sample_count,
+                        const Sink& sink) {
+    uint64_t first = sample_offset * sample_size;
+    if (first >= payload_bytes) {
+        return 0;
+    }
+    uint64_t length = payload_bytes - first;
+    if (sample_count * sample_size < length) {
+        length = sample_count * sample_size;
+    }
+    return read_range(fd, payload_offset + first, length, sink);
+}
+
+}  // namespace iq_read
@@ -0,0 +1,40 @@
+// Print samples of a stored recording straight from the device, see iq_read.h. read_range.sh finds the payload of
+// every member from the recording index and the tar headers and uses this tool for the samples when it is in bin/.
+// Usage: iq_read <device> <payload_byte_offset> <payload_bytes> [sample_offset] [sample_count] > samples.cs16
+// Build: see dependencies/sepp_build/build-iq-tools.sh
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "iq_read.h"
+
+int main(int argc, char** argv) {
+    if (argc < 4 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <device> <payload_byte_offset> <payload_bytes> [sample_offset] [sample_count]" << std::endl;
+        return 1;
+    }
+    uint64_t payload_offset = std::strtoull(argv[2], nullptr, 10);
+    uint64_t payload_bytes = std::strtoull(argv[3], nullptr, 10);
+    uint64_t sample_offset = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 0;
+    uint64_t sample_count = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : payload_bytes / iq_read::sample_size + 1;
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "iq_read: cannot open " << argv[1] << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    int status = iq_read::read_samples(fd, payload_offset, payload_bytes, sample_offset, sample_count,
+                                       [](const char* data, size_t bytes) { return fwrite(data, 1, bytes, stdout) == bytes; });
+    close(fd);
+    if (status != 0) {
+        std::cerr << "iq_read: read error: " << std::strerror(status) << std::endl;
+        return 1;
+    }
+    if (fflush(stdout) != 0 || ferror(stdout)) {
+        std::cerr << "iq_read: write error" << std::endl;
+        return 1;
+    }
+    return 0;
+}
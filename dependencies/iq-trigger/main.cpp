@@ -0,0 +1,188 @@
+// Energy trigger for cs16 IQ streams (interleaved little-endian int16 I and Q, as stored by exp202).
+// The last pre-trigger samples are kept in a ring in RAM. Only the windows around blocks whose power rises above the
+// noise floor are passed on, so intermittent signals are stored without the silence between them.
+// Usage: iq_trigger [-t threshold_dB] [-p pre_samples] [-w post_samples] [-e events.csv] < capture.cs16 > triggered.cs16
+// A block of 1024 samples fires when its mean power is threshold_dB (10 by default) above the noise floor, the running
+// average power of the blocks that did not fire. Every firing block extends its window by post_samples.
+// events.csv gets one line per window: event,capture_sample,stored_sample,samples,peak_dBFS
+// Build: see dependencies/sepp_build/build-iq-tools.sh, the power detector uses NEON when built for the SEPP.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+const int block_samples = 1024;
+const int block_bytes = block_samples * 4;
+const double full_scale = 2048; // 12-bit ADC
+const double floor_weight = 1.0 / 64;
+
+// Mean I^2 + Q^2 of n samples
+static double block_power(const int16_t* iq, int n) {
+    uint64_t sum = 0;
+    int i = 0;
+#ifdef __ARM_NEON
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 8 <= 2 * n; i += 8) {
+        int16x8_t v = vld1q_s16(iq + i);
+        // Every square fits into 31 bits
+        uint32x4_t lo = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+        uint32x4_t hi = vreinterpretq_u32_s32(vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+        acc = vpadalq_u32(acc, lo);
+        acc = vpadalq_u32(acc, hi);
+    }
+    sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+#endif
+    for (; i < 2 * n; i++) {
+        sum += uint64_t(int32_t(iq[i]) * iq[i]);
+    }
+    return n > 0 ? double(sum) / n : 0;
+}
+
+static double dbfs(double power) {
+    return 10 * std::log10((power > 1 ? power : 1) / (full_scale * full_scale));
+}
+
+int main(int argc, char** argv) {
+    double threshold_db = 10;
+    long pre_samples = 0;
+    long post_samples = block_samples;
+    const char* events_path = nullptr;
+    bool usage = argc % 2 == 0;
+    for (int a = 1; a + 1 < argc; a += 2) {
+        if (std::strcmp(argv[a], "-t") == 0) {
+            threshold_db = std::atof(argv[a + 1]);
+        } else if (std::strcmp(argv[a], "-p") == 0) {
+            pre_samples = std::atol(argv[a + 1]);
+        } else if (std::strcmp(argv[a], "-w") == 0) {
+            post_samples = std::atol(argv[a + 1]);
+        } else if (std::strcmp(argv[a], "-e") == 0) {
+            events_path = argv[a + 1];
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || pre_samples < 0 || post_samples < 0) {
+        std::cerr << "Usage: " << argv[0] << " [-t threshold_dB] [-p pre_samples] [-w post_samples] [-e events.csv]" << std::endl;
+        return 1;
+    }
+
+    FILE* events = nullptr;
+    if (events_path) {
+        events = std::fopen(events_path, "w");
+        if (!events) {
+            std::cerr << "iq_trigger: cannot open " << events_path << std::endl;
+            return 1;
+        }
+        std::fprintf(events, "event,capture_sample,stored_sample,samples,peak_dBFS\n");
+    }
+
+    static char in_buffer[1 << 20], out_buffer[1 << 20];
+    setvbuf(stdin, in_buffer, _IOFBF, sizeof(in_buffer));
+    setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+
+    // Pre-trigger ring of whole blocks, oldest at ring_first
+    int ring_blocks = (pre_samples + block_samples - 1) / block_samples;
+    std::vector<int16_t> ring(ring_blocks * block_samples * 2);
+    std::vector<int> ring_samples(ring_blocks);
+    int ring_first = 0;
+    int ring_used = 0;
+
+    std::vector<int16_t> block(block_samples * 2);
+    double noise_floor = -1;
+    double threshold = std::pow(10, threshold_db / 10);
+    bool open = false;
+    long remaining = 0;
+    long capture_sample = 0;
+    long stored_sample = 0;
+    long event = 0;
+    long event_start = 0;
+    long event_stored = 0;
+    double event_peak = 0;
+
+    auto close_event = [&]() {
+        if (events) {
+            std::fprintf(events, "%ld,%ld,%ld,%ld,%.1f\n", event, event_start, event_stored, stored_sample - event_stored, dbfs(event_peak));
+        }
+        open = false;
+        event++;
+    };
+
+    size_t got;
+    while ((got = fread(block.data(), 1, block_bytes, stdin)) >= 4) {
+        int n = got / 4;
+        double power = block_power(block.data(), n);
+        if (noise_floor < 0) {
+            noise_floor = power;
+        }
+        bool fires = power > noise_floor * threshold;
+        if (!fires) {
+            noise_floor += (power - noise_floor) * floor_weight;
+        }
+
+        if (fires && !open) {
+            // The pre-trigger history goes out first
+            open = true;
+            event_peak = 0;
+            long history = 0;
+            for (int b = 0; b < ring_used; b++) {
+                history += ring_samples[(ring_first + b) % ring_blocks];
+            }
+            // Only the last pre_samples of the ring, it holds whole blocks
+            long skip = history > pre_samples ? history - pre_samples : 0;
+            event_start = capture_sample - history + skip;
+            event_stored = stored_sample;
+            for (int b = 0; b < ring_used; b++) {
+                int slot = (ring_first + b) % ring_blocks;
+                long from = skip < ring_samples[slot] ? skip : ring_samples[slot];
+                skip -= from;
+                fwrite(ring.data() + (slot * block_samples + from) * 2, 4, ring_samples[slot] - from, stdout);
+                stored_sample += ring_samples[slot] - from;
+            }
+            ring_used = 0;
+        }
+
+        if (open) {
+            fwrite(block.data(), 4, n, stdout);
+            stored_sample += n;
+            if (fires) {
+                remaining = post_samples;
+                event_peak = power > event_peak ? power : event_peak;
+            } else {
+                remaining -= n;
+            }
+            if (remaining <= 0) {
+                close_event();
+            }
+        } else if (ring_blocks > 0) {
+            int slot = (ring_first + ring_used) % ring_blocks;
+            if (ring_used == ring_blocks) {
+                ring_first = (ring_first + 1) % ring_blocks;
+            } else {
+                ring_used++;
+            }
+            std::memcpy(ring.data() + slot * block_samples * 2, block.data(), n * 4);
+            ring_samples[slot] = n;
+        }
+        capture_sample += n;
+    }
+    if (open) {
+        close_event();
+    }
+
+    if (events) {
+        std::fclose(events);
+    }
+    if (ferror(stdin) || ferror(stdout)) {
+        std::cerr << "iq_trigger: read or write error" << std::endl;
+        return 1;
+    }
+    std::cerr << "iq_trigger: " << event << " windows, " << stored_sample << " of " << capture_sample << " samples kept" << std::endl;
+    return 0;
+}
@@ -0,0 +1,8 @@
+#!/usr/bin/env bash
+
+# Run inside the SEPP container (start-sepp-container.sh), the poky SDK sets $CXX for the Cortex-A8 with NEON.
+# Copy <tool>/build/* to src/home/exp266/bin/ afterwards.
+for tool in iq-codec iq-trigger iq-read; do
+    mkdir -p $tool/build
+    $CXX -O3 -o $tool/build/$(echo $tool | tr "-" "_") $tool/main.cpp
+done
@@ -14,28 +14,52 @@ mkdir -p $OUT_FOLDER
 
 downsample_shift=$(awk -F "=" '/downsample_shift/ {printf "%s",$2}' $CONFIG_FILE)
 downsample_cutoff_frequency=$(awk -F "=" '/downsample_cutoff_frequency/ {printf "%s",$2}' $CONFIG_FILE)
+recording_slot=$(awk -F "=" '/recording_slot/ {printf "%s",$2}' $CONFIG_FILE)
+processing_window=${2:-$(awk -F "=" '/processing_window/ {printf "%s",$2}' $CONFIG_FILE)}
 
 ## Static config
 samp_freq_index_lookup="1.5 1.75 3.5 3 3.84 5 5.5 6 7 8.75 10 12 14 20 24 28 32 36 40 60 76.8 80" # MHz
 lpf_bw_cfg_lookup="14 10 7 6 5 4.375 3.5 3 2.75 2.5 1.92 1.5 1.375 1.25 0.875 0.75" # MHz
 
-## Decode metadata from filename:
+## Read the metadata block, or decode the metadata from the filename of older recordings:
 echo "### Reading stored archive..."
 
-stored_filename=$($EXP_PATH/helper/peek_emmc.sh | awk '{ printf "%s",$6 }')
-
-echo "## Found recording: $stored_filename"
-
-echo "### Reading metadata from filename..."
-
-# Grep all parameter=value pairs
-pairs=$(echo "$stored_filename" | grep -o "\(.*=[0-9.]*\)")
+metadata=$($EXP_PATH/helper/read_metadata.sh "" $recording_slot)
+# An index entry that does not match what is stored means the archive at its offset is another recording
+if [ $? -eq 2 ]; then
+  echo "#### Slot ${recording_slot:-latest} of the recording index does not match the stored recording, check ./helper/list_recordings.sh verify!"
+  exit 2
+fi
 
-f_sampling_index=$(echo "$pairs" | grep -o "f_sampling_index=[0-9.]*" | cut -d'=' -f2)
-lpf_index=$(echo "$pairs" | grep -o "lpf_index=[0-9.]*" | cut -d'=' -f2)
-f_center=$(echo "$pairs" | grep -o "f_center=[0-9.]*" | cut -d'=' -f2)
-gain=$(echo "$pairs" | grep -o "gain=[0-9.]*" | cut -d'=' -f2)
-timestamp=$(echo "$pairs" | grep -o "timestamp=[0-9.]*" | cut -d'=' -f2)
+if [ -n "$metadata" ]; then
+  echo "### Reading metadata block..."
+  stored_filename=$($EXP_PATH/helper/read_metadata.sh member $recording_slot)
+  f_sampling_index=$($EXP_PATH/helper/read_metadata.sh samp_freq_index $recording_slot)
+  lpf_index=$($EXP_PATH/helper/read_metadata.sh lpf_index $recording_slot)
+  f_center=$($EXP_PATH/helper/read_metadata.sh carrier_GHz $recording_slot)
+  gain=$($EXP_PATH/helper/read_metadata.sh gain_dB $recording_slot)
+  timestamp=$($EXP_PATH/helper/read_metadata.sh start_epoch_s $recording_slot)
+  stored_sampling_Hz=$($EXP_PATH/helper/read_metadata.sh output_sampling_Hz $recording_slot)
+  stored_shift=$($EXP_PATH/helper/read_metadata.sh f_shift_Hz $recording_slot)
+  echo "## Found recording: $stored_filename (slot $($EXP_PATH/helper/read_metadata.sh slot $recording_slot))"
+else
+  stored_filename=$($EXP_PATH/helper/peek_emmc.sh | awk 'NR == 1 { printf "%s",$6 }')
+
+  echo "## Found recording: $stored_filename"
+
+  echo "### Reading metadata from filename..."
+
+  # Grep all parameter=value pairs
+  pairs=$(echo "$stored_filename" | grep -o "\(.*=[0-9.]*\)")
+
+  f_sampling_index=$(echo "$pairs" | grep -o "f_sampling_index=[0-9.]*" | cut -d'=' -f2)
+  lpf_index=$(echo "$pairs" | grep -o "lpf_index=[0-9.]*" | cut -d'=' -f2)
+  f_center=$(echo "$pairs" | grep -o "f_center=[0-9.]*" | cut -d'=' -f2)
+  gain=$(echo "$pairs" | grep -o "gain=[0-9.]*" | cut -d'=' -f2)
+  timestamp=$(echo "$pairs" | grep -o "timestamp=[0-9.]*" | cut -d'=' -f2)
+  stored_sampling_Hz=$(echo "$pairs" | grep -o "f_sampling=[0-9.]*" | cut -d'=' -f2)
+  stored_shift=$(echo "$pairs" | grep -o "f_shift=[-0-9.]*" | cut -d'=' -f2)
+fi
 
 # Decode indexes into real values
 
@@ -45,7 +69,19 @@ lpf_realvalue=$(echo $lpf_bw_cfg_lookup | cut -d " " -f $(($lpf_index+1)))
 # Print metadata
 
 sampling_Hz=$(python3 -c "print(round($sampling_realvalue*1000000))")
+mix_shift=$downsample_shift
+# Narrowband recordings (see record.sh) are stored already mixed by their own shift and decimated
+if [ -n "$stored_sampling_Hz" ]; then
+  sampling_Hz=$stored_sampling_Hz
+  mix_shift=$(python3 -c "print(round($downsample_shift - $stored_shift))")
+  sampling_realvalue=$(python3 -c "print($sampling_Hz/1000000)")
+  echo "## Narrowband recording: stored at $sampling_Hz Hz around $stored_shift Hz, mixing by the remaining $mix_shift Hz"
+fi
 decimation_rate=$(python3 -c "print(int($sampling_Hz/$downsample_cutoff_frequency))")
+if [ $decimation_rate -lt 1 ]; then
+  echo "#### The bandwidth of $downsample_cutoff_frequency Hz is wider than the stored $sampling_Hz Hz, nothing to downsample!"
+  exit 1
+fi
 output_sample_rate=$(python3 -c "print(int($sampling_Hz/$decimation_rate))");
 new_center=$(python3 -c "print($f_center*1000+$downsample_shift/1000000)")
 
@@ -65,6 +101,7 @@ MOTD="
   Shift:            $downsample_shift Hz;
   New frequency:    $new_center MHz;
   New sampling rate:$output_sample_rate Hz;
+  Window:           ${processing_window:-all};
   
 "
 echo "$MOTD"
@@ -73,8 +110,23 @@ filename=sdr_exp266_downsampled-f_center=${f_center}-f_shift=${downsample_shift}
 
 echo "### Starting resampling to file: $filename"
 
+# Samples straight from their byte range of the partition, or through tar for recordings stored before the metadata block
+# Only the part of the recording inside the processing window is read (see helper/seek_window.sh)
+read_samples() {
+  if [ -n "$metadata" ] && [ "${processing_window:-all}" != "all" ]; then
+    $EXP_PATH/helper/seek_window.sh "$processing_window" "$recording_slot" | while read segment sample_offset sample_count byte_offset gap_samples; do
+      echo "### Segment $segment: $sample_count samples from sample $sample_offset" >&2
+      $EXP_PATH/helper/read_range.sh "$recording_slot" $sample_offset $sample_count $segment
+    done
+  elif [ -n "$metadata" ]; then
+    $EXP_PATH/helper/read_range.sh "$recording_slot"
+  else
+    $EXP_PATH/helper/stream_emmc.sh | tar -xvO
+  fi
+}
+
 ## Works on EM:
-$EXP_PATH/helper/stream_emmc.sh | tar -xvO | $BINARY_PATH/iq_toolbox/iq_mix -s $sampling_Hz -m $downsample_shift | $BINARY_PATH/iq_toolbox/iq_decimate -s $sampling_Hz -f $downsample_cutoff_frequency -o $OUT_FOLDER/$filename
+read_samples | $BINARY_PATH/iq_toolbox/iq_mix -s $sampling_Hz -m $mix_shift | $BINARY_PATH/iq_toolbox/iq_decimate -s $sampling_Hz -f $downsample_cutoff_frequency -o $OUT_FOLDER/$filename
 
 downsample_waterfall=$(awk -F "=" '/downsample_waterfall/ {printf "%s",$2}' $CONFIG_FILE)
 downsample_fft_size=$(awk -F "=" '/downsample_fft_size/ {printf "%s",$2}' $CONFIG_FILE)
@@ -8,6 +8,13 @@ DATE=$(date +"%Y%m%d_%H%M%S")
 RECORDING_PATH=$(awk -F "=" '/recording_path/ {printf "%s",$2}' $CONFIG_FILE)
 OUTPUT_PATH=${1:-"$EXP_PATH/toGround/$DATE"}
 DOWNLINK_PATH=$(awk -F "=" '/downlink_path/ {printf "%s",$2}' $CONFIG_FILE)
+recording_slot=$(awk -F "=" '/recording_slot/ {printf "%s",$2}' $CONFIG_FILE)
+downlink_chunked=$(awk -F "=" '/downlink_chunked/ {printf "%s",$2}' $CONFIG_FILE)
+if [[ $downlink_chunked == true ]]; then
+  downlink_samples_script=$EXP_PATH/helper/downlink_chunks.sh
+else
+  downlink_samples_script=$EXP_PATH/helper/downlink_from_emmc.sh
+fi
 mkdir -p $DOWNLINK_PATH
 
 ## Run one of the routines:
@@ -42,8 +49,12 @@ if [[ "$action" == "downsample" ]]; then
   $EXP_PATH/downsample.sh $OUTPUT_PATH
 fi
 
+if [[ "$action" == "benchmark" ]]; then
+  $EXP_PATH/helper/benchmark_sampling_rates.sh $OUTPUT_PATH
+fi
+
 if [[ "$action" == "downlink" ]]; then
-  $EXP_PATH/helper/downlink_from_emmc.sh $DOWNLINK_PATH
+  $downlink_samples_script $DOWNLINK_PATH $recording_slot
 fi
 
 ## Downlink
@@ -52,7 +63,7 @@ downlink_samples=$(awk -F "=" '/downlink_samples/ {printf "%s",$2}' $CONFIG_FILE
 ## Downlink from eMMC
 if [[ $downlink_samples == true ]]; then
     echo "#### Restore samples from eMMC and put for downlink."
-    $EXP_PATH/helper/downlink_from_emmc.sh $DOWNLINK_PATH
+    $downlink_samples_script $DOWNLINK_PATH $recording_slot
 else
     echo "#### Samples stored in the eMMC. To downlink them later, run 'cd /home/exp266; ./helper/downlink_from_emmc.sh'"
 fi
@@ -0,0 +1,98 @@
+#!/usr/bin/env sh
+
+## Pick the RX gain from a few short captures before the main recording and write it into the exp202 running config.
+## Usage: ./helper/auto_gain.sh <running_config.ini> [target_rms_dBFS]
+## Every probe captures a short burst and computes the RMS, the clipping fraction and a histogram of the sample magnitudes.
+## The gain is moved towards the target RMS (and at least 6 dB down when the burst clips) until it settles.
+
+EXP_PATH=$(dirname $0)/..
+BINARY_PATH=$EXP_PATH/bin
+running_config=$1
+target_dbfs=${2:-"-18"}
+
+exp202_binary=exp202-tar_write
+probe_samples=65536
+max_probes=4
+probe_config=/tmp/exp266_agc.ini
+probe_fifo=/tmp/exp266_agc.fifo
+probe_file=/tmp/exp266_agc.cs16
+
+if [ -z "$running_config" ]; then
+    echo "Usage: $0 <running_config.ini> [target_rms_dBFS]"
+    exit 1
+fi
+
+# RMS [dBFS], clipping [%], next gain [dB] and the magnitude histogram [% per 1/8 of full scale] of one burst
+burst_statistics() {
+    python3 - $1 $2 $target_dbfs <<'PY'
+import array, math, sys
+
+full_scale = 2048  # 12-bit ADC
+samples = array.array("h")
+with open(sys.argv[1], "rb") as f:
+    data = f.read()
+samples.frombytes(data[:len(data) - len(data) % 2])
+gain, target = int(sys.argv[2]), float(sys.argv[3])
+
+n = max(len(samples), 1)
+rms = math.sqrt(sum(x * x for x in samples) / n)
+rms_dbfs = 20 * math.log10(max(rms, 1) / full_scale)
+clipped = sum(1 for x in samples if abs(x) >= full_scale - 1) / n
+histogram = [0] * 8
+for x in samples:
+    histogram[min(abs(x) * 8 // full_scale, 7)] += 1
+
+step = target - rms_dbfs
+if clipped > 0.001:
+    step = min(step, -6)
+next_gain = min(max(int(round(gain + step)), 12), 72)
+print("%.1f %.3f %d %s" % (rms_dbfs, 100 * clipped, next_gain, ",".join("%.1f" % (100 * h / n) for h in histogram)))
+PY
+}
+
+gain=$(awk -F " = " '/gain_db/ {printf "%s",$2}' $running_config)
+
+probe=1
+while [ $probe -le $max_probes ]; do
+    sed -e "s/^gain_db = .*/gain_db = $gain/" \
+        -e "s/^number_of_samples = .*/number_of_samples = $probe_samples/" \
+        -e "s/^calibrate_frontend = .*/calibrate_frontend = 0/" \
+        -e "s|^output_path = .*|output_path = $probe_fifo|" $running_config > $probe_config
+    rm -f $probe_fifo
+    mkfifo $probe_fifo
+    tar -xO < $probe_fifo > $probe_file &
+    reader_pid=$!
+    if ! $BINARY_PATH/$exp202_binary $probe_config > /dev/null; then
+        # The reader is still blocked opening the pipe if exp202 failed before opening it
+        kill $reader_pid 2>/dev/null
+        wait $reader_pid
+        echo "#### AGC probe failed, keeping gain $gain dB."
+        break
+    fi
+    # End of stream for the reader in case exp202 never opened the pipe
+    : <> $probe_fifo
+    wait $reader_pid
+    if [ ! -s $probe_file ]; then
+        echo "#### AGC probe returned no samples, keeping gain $gain dB."
+        break
+    fi
+
+    set -- $(burst_statistics $probe_file $gain)
+    next_gain=$3
+    case "$next_gain" in
+        ''|*[!0-9]*)
+            echo "#### AGC probe statistics failed, keeping gain $gain dB."
+            break
+            ;;
+    esac
+    echo "#### AGC probe $probe: gain $gain dB, RMS $1 dBFS, clipping $2 %, magnitude histogram [%]: $4"
+    if [ $next_gain -ge $(($gain - 1)) ] && [ $next_gain -le $(($gain + 1)) ]; then
+        break
+    fi
+    gain=$next_gain
+    probe=$(($probe+1))
+done
+
+rm -f $probe_config $probe_fifo $probe_file
+echo "#### AGC decision: gain $gain dB (target RMS $target_dbfs dBFS)"
+sed -i "s/^gain_db = .*/gain_db = $gain/" $running_config
@@ -0,0 +1,72 @@
+#!/usr/bin/env sh
+
+## Compare the lossless IQ codec (bin/iq_codec, built from dependencies/iq-codec) with gzip -1 on the samples of a stored recording.
+## Usage: ./helper/benchmark_compression.sh [output_folder] [slot] [megabytes]
+## The first megabytes (16 by default) of samples of the recording are read into /tmp once, so the eMMC does not count
+## in the timings. The codec output is decoded again and compared with the samples, the benchmark fails when it differs.
+##
+## Reported per compressor:
+##   ratio             - input bytes / output bytes
+##   compress_MBps     - input bytes per second while compressing
+##   decompress_MBps   - input bytes per second while decompressing
+
+EXP_PATH=$(dirname $0)/..
+BINARY_PATH=$EXP_PATH/bin
+DATE=$(date +"%Y%m%d_%H%M%S")
+OUTPUT_PATH=${1:-"$EXP_PATH/toGround/benchmark_compression_$DATE"}
+slot=${2:-latest}
+megabytes=${3:-16}
+mkdir -p $OUTPUT_PATH
+
+REPORT=$OUTPUT_PATH/benchmark_compression.csv
+samples_file=/tmp/exp266_compression.cs16
+packed_file=/tmp/exp266_compression.packed
+unpacked_file=/tmp/exp266_compression.unpacked
+
+uptime_s() {
+    cut -d " " -f1 /proc/uptime
+}
+
+# Seconds the command line takes, input on stdin and output to stdout redirected by the caller
+timed() {
+    local start=$(uptime_s)
+    "$@" || return 1
+    awk "BEGIN {e = $(uptime_s) - $start; print (e > 0) ? e : 0.01}" >&2
+}
+
+# <name> <compress command> <decompress command>
+benchmark() {
+    local name=$1
+    local compress=$2
+    local decompress=$3
+    local compress_s=$(timed $compress < $samples_file 2>&1 > $packed_file)
+    local decompress_s=$(timed $decompress < $packed_file 2>&1 > $unpacked_file)
+    if ! cmp -s $samples_file $unpacked_file; then
+        echo "#### $name did not give back the samples!"
+        echo "$name,-" >> $REPORT
+        return 1
+    fi
+    local input_bytes=$(wc -c < $samples_file)
+    local output_bytes=$(wc -c < $packed_file)
+    awk "BEGIN {printf \"%s,%d,%d,%.3f,%.2f,%.2f\\n\", \"$name\", $input_bytes, $output_bytes, $input_bytes / $output_bytes, \
+        $input_bytes / $compress_s / 1000000, $input_bytes / $decompress_s / 1000000}" >> $REPORT
+    tail -n1 $REPORT
+}
+
+echo "### Reading $megabytes MB of samples of slot $slot..."
+$EXP_PATH/helper/read_range.sh $slot 0 $(($megabytes * 262144)) 2>/dev/null | head -c $(($megabytes * 1048576)) > $samples_file
+if [ ! -s $samples_file ]; then
+    echo "No samples read from slot $slot, see ./helper/list_recordings.sh"
+    rm -f $samples_file
+    exit 1
+fi
+
+echo "compressor,input_bytes,output_bytes,ratio,compress_MBps,decompress_MBps" > $REPORT
+status=0
+benchmark "gzip -1" "gzip -1" "gzip -d" || status=1
+benchmark iq_codec $BINARY_PATH/iq_codec "$BINARY_PATH/iq_codec -d" || status=1
+
+rm -f $samples_file $packed_file $unpacked_file
+echo "#### Benchmark finished! Report: $REPORT"
+cat $REPORT
+exit $status
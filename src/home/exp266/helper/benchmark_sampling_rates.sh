@@ -0,0 +1,152 @@
+#!/usr/bin/env sh
+
+## Measure the sustained capture-to-eMMC rate for every sampling frequency code (SDR API enum eSDR_RFFE_RX_SAMPLING_FREQ).
+## Usage: ./helper/benchmark_sampling_rates.sh [output_folder] [seconds_per_rate]
+## Warning! Every step is a real recording to recording_path - it overwrites the samples stored in the partition
+## and clears the recording index. A step never records more than fits into the partition, fast rates get a shorter capture.
+## With EMMC_IMAGE set, the samples come from simulate_recording.sh paced at the nominal rate instead of the SDR.
+##
+## Reported per sampling frequency:
+##   achieved_MSps  - samples / time from "IQ capture: Starting" until the capture is written back to the eMMC
+##                    (blockdev --flushbufs after exp202 exits), so the page cache does not hide the eMMC rate
+##   cpuN_pct       - load of each core over the same span (/proc/stat)
+##   dropped_bytes_est - estimate, not measured: nominal rate x that span minus the samples recorded, in bytes. The same
+##                    information as achieved_MSps, exp202 does not report lost DMA buffers.
+##   write_lat_*_ms - percentiles of the eMMC write latency, averaged over 200 ms windows (/sys/block/mmcblk0/stat)
+
+EXP_PATH=$(dirname $0)/..
+BINARY_PATH=$EXP_PATH/bin
+CONFIG_FILE=$EXP_PATH/config.ini
+DATE=$(date +"%Y%m%d_%H%M%S")
+OUTPUT_PATH=${1:-"$EXP_PATH/toGround/benchmark_$DATE"}
+seconds=${2:-2}
+mkdir -p $OUTPUT_PATH
+
+exp202_binary=exp202-tar_write
+emmc_device=mmcblk0
+sample_size=4 #bytes
+max_samples=$(((376704 - 3) * 128)) # P180 without the recording index, header and end-of-archive marker
+
+carrier_frequency_GHz=$(awk -F "=" '/carrier_frequency_GHz/ {printf "%s",$2}' $CONFIG_FILE)
+lpf_bw_cfg=$(awk -F "=" '/lpf_bw_cfg/ {printf "%s",$2}' $CONFIG_FILE)
+gain_db=$(awk -F "=" '/gain_db/ {printf "%s",$2}' $CONFIG_FILE)
+RECORDING_PATH=${EMMC_IMAGE:-$(awk -F "=" '/recording_path/ {printf "%s",$2}' $CONFIG_FILE)}
+
+samp_freq_index_lookup="1.5 1.75 3.5 3 3.84 5 5.5 6 7 8.75 10 12 14 20 24 28 32 36 40 60 76.8 80" # MHz
+
+REPORT=$OUTPUT_PATH/benchmark_sampling_rates.csv
+
+uptime_s() {
+    cut -d " " -f1 /proc/uptime
+}
+
+# Prefix every line with the uptime and snapshot the per-core counters at the capture markers
+timestamp_capture() {
+    local log=$1
+    while read line; do
+        case "$line" in
+            *"IQ capture: Starting"*) grep "^cpu[0-9]" /proc/stat > $log.cpu_start ;;
+        esac
+        echo "$(uptime_s) $line"
+    done > $log
+}
+
+# Average write latency [ms] of each 200 ms window in which the eMMC completed writes
+sample_write_latency() {
+    local prev_ios=0
+    local prev_ticks=0
+    while true; do
+        set -- $(cat /sys/block/$emmc_device/stat)
+        if [ $prev_ios -gt 0 ] && [ $5 -gt $prev_ios ]; then
+            awk "BEGIN {printf \"%.2f\\n\", ($8 - $prev_ticks) / ($5 - $prev_ios)}"
+        fi
+        prev_ios=$5
+        prev_ticks=$8
+        sleep 0.2
+    done
+}
+
+percentile() {
+    sort -n $1 | awk -v p=$2 '{ v[NR] = $1 } END { if (NR == 0) { print "-"; exit } i = int(NR * p + 0.5); if (i < 1) i = 1; if (i > NR) i = NR; print v[i] }'
+}
+
+# Busy percentage of every core between two /proc/stat snapshots, ex. "87.5 12.0"
+cpu_load() {
+    awk 'NR == FNR { total[$1] = $2+$3+$4+$5+$6+$7+$8; idle[$1] = $5+$6; next }
+         { dt = $2+$3+$4+$5+$6+$7+$8 - total[$1]; di = $5+$6 - idle[$1]; printf "%.1f ", (dt > 0) ? 100 * (dt - di) / dt : 0 }' $1 $2
+}
+
+echo "### Benchmarking $seconds s per sampling frequency, recording to $RECORDING_PATH"
+cpu_columns=$(grep "^cpu[0-9]" /proc/stat | awk '{ printf ",%s_pct", $1 }')
+# The index would describe recordings the benchmark overwrites
+$EXP_PATH/helper/write_metadata.sh $RECORDING_PATH clear
+
+echo "samp_freq_index,nominal_MSps,achieved_MSps${cpu_columns},dropped_bytes_est,write_lat_p50_ms,write_lat_p95_ms,write_lat_p99_ms" > $REPORT
+
+samp_freq_index=0
+for sampling_realvalue in $samp_freq_index_lookup; do
+    number_of_samples=$(awk "BEGIN {printf \"%d\", $sampling_realvalue*1000000*$seconds}")
+    if [ $number_of_samples -gt $max_samples ]; then
+        number_of_samples=$max_samples
+    fi
+    log=$OUTPUT_PATH/benchmark_${samp_freq_index}.log
+    echo "#### Sampling frequency $sampling_realvalue MHz (id: $samp_freq_index), $number_of_samples samples"
+
+    if [ -z "$EMMC_IMAGE" ]; then
+        sample_write_latency > $log.latency &
+        latency_pid=$!
+    fi
+
+    if [ -n "$EMMC_IMAGE" ]; then
+        rate_MBps=$(awk "BEGIN {print $sampling_realvalue*$sample_size}")
+        # Logs the capture markers itself, around the paced write only
+        $EXP_PATH/helper/simulate_recording.sh $samp_freq_index $number_of_samples $rate_MBps 2>&1 | timestamp_capture $log
+    else
+        # Calibration is skipped, only the capture is measured
+        CONFIG="[SEPP_SDR_RX]
+carrier_frequency_GHz = $carrier_frequency_GHz
+samp_freq_index = $samp_freq_index
+lpf_bw_cfg = $lpf_bw_cfg
+gain_db = $gain_db
+number_of_samples = $number_of_samples
+calibrate_frontend = 0
+output_path = $RECORDING_PATH"
+        echo "$CONFIG" > $OUTPUT_PATH/running_config.ini
+        $BINARY_PATH/$exp202_binary $OUTPUT_PATH/running_config.ini 2>&1 | timestamp_capture $log
+    fi
+    # The written-back end of the capture closes the timed span
+    if [ -n "$EMMC_IMAGE" ]; then
+        sync
+    else
+        blockdev --flushbufs $RECORDING_PATH
+    fi
+    grep "^cpu[0-9]" /proc/stat > $log.cpu_end
+    echo "$(uptime_s) IQ capture: Written back" >> $log
+
+    if [ -n "$latency_pid" ]; then
+        kill $latency_pid
+        latency_pid=
+    fi
+    touch $log.latency
+
+    start=$(awk '/IQ capture: Starting/ {print $1; exit}' $log)
+    end=$(awk '/IQ capture: Written back/ {print $1; exit}' $log)
+    if [ -z "$start" ] || ! grep -q "IQ capture: Finished" $log; then
+        echo "Capture did not finish, see $log"
+        echo "$samp_freq_index,$sampling_realvalue,-" >> $REPORT
+    else
+        elapsed=$(awk "BEGIN {e = $end - $start; print (e > 0) ? e : 0.01}")
+        achieved=$(awk "BEGIN {printf \"%.3f\", $number_of_samples/$elapsed/1000000}")
+        dropped=$(awk "BEGIN {d = ($sampling_realvalue*1000000*$elapsed - $number_of_samples)*$sample_size; printf \"%d\", (d > 0) ? d : 0}")
+        cpu=$(cpu_load $log.cpu_start $log.cpu_end | tr " " "," | sed "s/,$//")
+        echo "$samp_freq_index,$sampling_realvalue,$achieved,$cpu,$dropped,$(percentile $log.latency 0.5),$(percentile $log.latency 0.95),$(percentile $log.latency 0.99)" >> $REPORT
+    fi
+    tail -n1 $REPORT
+
+    samp_freq_index=$(($samp_freq_index+1))
+done
+
+rm -f $OUTPUT_PATH/running_config.ini $OUTPUT_PATH/*.cpu_start $OUTPUT_PATH/*.cpu_end
+
+echo "#### Benchmark finished! Report: $REPORT"
+cat $REPORT
@@ -0,0 +1,104 @@
+#!/usr/bin/env sh
+
+## Work on a stored recording in 1 MiB chunks of its archive, each protected by the CRC-32 (as in gzip) noted in the
+## recording index when it was stored (chunk_crc32, see record.sh), so damage can be narrowed down to single chunks
+## and the recording can be moved in pieces (see downlink_chunks.sh).
+## Usage: ./helper/chunks.sh crc                               CRC-32 of every chunk of stdin, 8 hex digits each, concatenated
+##        ./helper/chunks.sh manifest [slot]                   chunk,byte_offset,bytes,crc32 (hex) of every chunk, from the index
+##        ./helper/chunks.sh verify [slot] [first] [last]      read the chunks back and list the ones that do not match
+##        ./helper/chunks.sh extract [slot] [first] [last]     print the chunks, concatenated they give back the tar archive
+## The slot is the one of the recording index (see list_recordings.sh), the latest recording by default. Chunks count from 0.
+
+command=$1
+slot=${2:-latest}
+first=${3:-0}
+last=$4
+
+chunk_size=1048576
+
+if [ "$command" = "crc" ]; then
+    python3 -c "
+import sys, zlib
+crcs = []
+while True:
+    chunk = sys.stdin.buffer.read($chunk_size)
+    if not chunk:
+        break
+    crcs.append('%08x' % zlib.crc32(chunk))
+print(''.join(crcs))
+"
+    exit 0
+fi
+
+## EMMC_IMAGE=<file> reads a p180 image instead of the eMMC, p180 falls back to its range of mmcblk0 (see stream_emmc.sh)
+if [ -n "$EMMC_IMAGE" ]; then
+    device=$EMMC_IMAGE
+    partition_block=0
+elif [ -b /dev/mmcblk0p180 ]; then
+    device=/dev/mmcblk0p180
+    partition_block=0
+else
+    device=/dev/mmcblk0
+    partition_block=13680640 # P180 start, 512-byte blocks
+fi
+
+metadata=$($(dirname $0)/read_metadata.sh "" $slot)
+# Fixed width, so the checksums of a full partition take 1.5 KiB of the 4 KiB slot
+crcs=$(echo "$metadata" | sed -n 's/.*"chunk_crc32":"\([0-9a-f]*\)".*/\1/p' | sed 's/.\{8\}/& /g')
+if [ -z "$crcs" ]; then
+    echo "No chunk checksums for slot $slot in the recording index" >&2
+    exit 1
+fi
+block_offset=$(echo "$metadata" | sed -n 's/.*"block_offset":\([0-9]*\).*/\1/p')
+archive_bytes=$(($(echo "$metadata" | sed -n 's/.*"blocks":\([0-9]*\).*/\1/p') * 512))
+chunks=$(echo $crcs | wc -w)
+last=${last:-$(($chunks - 1))}
+if [ $last -ge $chunks ]; then
+    last=$(($chunks - 1))
+fi
+
+# Print chunks first to last of the archive, read in 4 KiB blocks (recordings are 4 KiB aligned)
+read_chunks() {
+    local start=$(($1 * $chunk_size))
+    local end=$((($2 + 1) * $chunk_size))
+    if [ $end -gt $archive_bytes ]; then
+        end=$archive_bytes
+    fi
+    dd if=$device bs=4096 skip=$((($partition_block + $block_offset) / 8 + $start / 4096)) count=$((($end - $start + 4095) / 4096)) 2>/dev/null | head -c $(($end - $start))
+}
+
+case "$command" in
+    manifest)
+        echo "chunk,byte_offset,bytes,crc32"
+        chunk=0
+        for crc in $crcs; do
+            bytes=$(($archive_bytes - $chunk * $chunk_size))
+            if [ $bytes -gt $chunk_size ]; then
+                bytes=$chunk_size
+            fi
+            echo "$chunk,$(($chunk * $chunk_size)),$bytes,$crc"
+            chunk=$(($chunk + 1))
+        done
+        ;;
+    verify)
+        stored=$(read_chunks $first $last | $(dirname $0)/chunks.sh crc | sed 's/.\{8\}/& /g')
+        bad=0
+        chunk=$first
+        for crc in $stored; do
+            if [ "$crc" != "$(echo $crcs | cut -d " " -f $(($chunk + 1)))" ]; then
+                echo "Chunk $chunk damaged (bytes $(($chunk * $chunk_size)) to $((($chunk + 1) * $chunk_size - 1)) of the archive)"
+                bad=$(($bad + 1))
+            fi
+            chunk=$(($chunk + 1))
+        done
+        echo "Chunks $first to $last: $bad damaged"
+        [ $bad -eq 0 ]
+        ;;
+    extract)
+        read_chunks $first $last
+        ;;
+    *)
+        echo "Usage: $0 crc|manifest|verify|extract [slot] [first] [last]"
+        exit 1
+        ;;
+esac
@@ -57,4 +57,8 @@ check_or_create_partition() {
 
 #set +ex
 
-check_or_create_partition
\ No newline at end of file
+if [ -n "$EMMC_IMAGE" ]; then
+    echo "Using partition image $EMMC_IMAGE instead of /dev/mmcblk0p$partition."
+else
+    check_or_create_partition
+fi
\ No newline at end of file
@@ -0,0 +1,57 @@
+#!/usr/bin/env sh
+
+## Put a stored recording into the downlink folder chunk by chunk (see chunks.sh), one compressed file per 1 MiB chunk,
+## next to the chunk manifest. Chunks already put there by an earlier run are skipped, so an interrupted downlink
+## resumes where it stopped and a large recording can be spread over several passes.
+## Usage: ./helper/downlink_chunks.sh [path_to_save_files] [slot] [first_chunk] [last_chunk]
+## A chunk that does not match its CRC is reported and left out, the other chunks still go down.
+## On ground: check every chunk against the manifest, then cat the chunks in order | tar -x gives back the recording.
+
+$(dirname $0)/create_emmc_partition.sh
+
+DOWNLINK_PATH=${1:-"/esoc-apps-flash/fms/filestore/toGround"}
+slot=${2:-latest}
+first=${3:-0}
+last=$4
+mkdir -p $DOWNLINK_PATH
+
+# Chunks already downlinked, one "<member> <chunk>" per line, kept across runs
+progress_file=$(dirname $0)/../downlinked_chunks.txt
+chunk_file=/tmp/exp266_chunk.bin
+
+echo "### Reading stored archive..."
+stored_filename=$($(dirname $0)/read_metadata.sh member $slot)
+if [ -z "$stored_filename" ]; then
+    echo "## No recording in slot $slot of the recording index, use ./helper/downlink_from_emmc.sh"
+    exit 1
+fi
+echo "## Found recording: $stored_filename"
+
+manifest=$($(dirname $0)/chunks.sh manifest $slot) || exit 1
+echo "$manifest" > $DOWNLINK_PATH/exp266_chunks_${stored_filename}.csv
+last=${last:-$(($(echo "$manifest" | wc -l) - 2))}
+
+echo "### Downlinking chunks $first to $last to $DOWNLINK_PATH"
+chunk=$first
+while [ $chunk -le $last ]; do
+    name=exp266_chunk_${stored_filename}_$(printf "%04d" $chunk).gz
+    if grep -qxF "$stored_filename $chunk" $progress_file 2>/dev/null; then
+        echo "## Chunk $chunk already downlinked"
+    else
+        # Read once into RAM (1 MiB), check it against the manifest, then compress
+        $(dirname $0)/chunks.sh extract $slot $chunk $chunk > $chunk_file
+        if [ "$($(dirname $0)/chunks.sh crc < $chunk_file)" != "$(echo "$manifest" | awk -F "," -v chunk=$chunk '$1 == chunk { print $4 }')" ]; then
+            echo "## Chunk $chunk damaged, left out!"
+        else
+            gzip -1 < $chunk_file > $DOWNLINK_PATH/$name.part
+            mv $DOWNLINK_PATH/$name.part $DOWNLINK_PATH/$name
+            echo "$stored_filename $chunk" >> $progress_file
+            echo "## Chunk $chunk: $name"
+        fi
+    fi
+    chunk=$(($chunk + 1))
+done
+rm -f $chunk_file
+
+echo "### Content of the downlink folder:"
+ls -lhR $DOWNLINK_PATH
@@ -7,16 +7,29 @@ $(dirname $0)/create_emmc_partition.sh
 #set -x
 
 DOWNLINK_PATH=${1:-"/esoc-apps-flash/fms/filestore/toGround"}
+## The second argument selects the recording by its slot in the recording index (see list_recordings.sh), the latest one by default.
+recording_slot=$2
 mkdir -p $DOWNLINK_PATH
 
 echo "### Reading stored archive..."
 
-stored_filename=$($(dirname $0)/peek_emmc.sh | awk '{ printf "%s",$6 }')
+stored_filename=$($(dirname $0)/read_metadata.sh member $recording_slot)
+if [ $? -eq 2 ]; then
+    echo "#### Slot ${recording_slot:-latest} of the recording index does not match the stored recording, check ./helper/list_recordings.sh verify!"
+    exit 2
+elif [ -z "$stored_filename" ]; then
+    stored_filename=$($(dirname $0)/peek_emmc.sh | awk 'NR == 1 { printf "%s",$6 }')
+fi
 
 echo "## Found recording: $stored_filename"
 echo "### Restoring to $DOWNLINK_PATH"
 
-$(dirname $0)/stream_emmc.sh | tar -xvO | gzip -1 -v > $DOWNLINK_PATH/exp266_restored_${stored_filename}.gz
+# Samples straight from their byte range of the partition, or through tar for recordings stored before the metadata block
+if [ -n "$($(dirname $0)/read_metadata.sh slot $recording_slot)" ]; then
+    $(dirname $0)/read_range.sh "$recording_slot"
+else
+    $(dirname $0)/stream_emmc.sh | tar -xvO
+fi | gzip -1 -v > $DOWNLINK_PATH/exp266_restored_${stored_filename}.gz
 
 # echo "### Content of the restored file:"
 # gnu_tar.tar tvf $DOWNLINK_PATH/$stored_filename.tar.gz
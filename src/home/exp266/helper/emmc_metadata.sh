@@ -5,23 +5,45 @@
 samp_freq_index_lookup="1.5 1.75 3.5 3 3.84 5 5.5 6 7 8.75 10 12 14 20 24 28 32 36 40 60 76.8 80" # MHz
 lpf_bw_cfg_lookup="14 10 7 6 5 4.375 3.5 3 2.75 2.5 1.92 1.5 1.375 1.25 0.875 0.75" # MHz
 
-## Decode metadata from filename:
+## Usage: ./helper/emmc_metadata.sh [slot]
+## The slot of the recording in the recording index (see list_recordings.sh), the latest one by default.
+recording_slot=$1
+
+## Read the metadata block, or decode the metadata from the filename of older recordings:
 echo "### Reading stored archive..."
 
-stored_filename=$($(dirname $0)/peek_emmc.sh | awk '{ printf "%s",$6 }')
+metadata=$($(dirname $0)/read_metadata.sh "" $recording_slot)
+# An index entry that does not match what is stored means the archive at its offset is another recording
+if [ $? -eq 2 ]; then
+  echo "#### Slot ${recording_slot:-latest} of the recording index does not match the stored recording, check ./helper/list_recordings.sh verify!"
+  exit 2
+fi
+
+if [ -n "$metadata" ]; then
+  echo "### Reading metadata block..."
+  stored_filename=$($(dirname $0)/read_metadata.sh member $recording_slot)
+  f_sampling_index=$($(dirname $0)/read_metadata.sh samp_freq_index $recording_slot)
+  lpf_index=$($(dirname $0)/read_metadata.sh lpf_index $recording_slot)
+  f_center=$($(dirname $0)/read_metadata.sh carrier_GHz $recording_slot)
+  gain=$($(dirname $0)/read_metadata.sh gain_dB $recording_slot)
+  timestamp=$($(dirname $0)/read_metadata.sh start_epoch_s $recording_slot)
+  echo "## Found recording: $stored_filename (slot $($(dirname $0)/read_metadata.sh slot $recording_slot))"
+else
+  stored_filename=$($(dirname $0)/peek_emmc.sh | awk 'NR == 1 { printf "%s",$6 }')
 
-echo "## Found recording: $stored_filename"
+  echo "## Found recording: $stored_filename"
 
-echo "### Reading metadata from filename..."
+  echo "### Reading metadata from filename..."
 
-# Grep all parameter=value pairs
-pairs=$(echo "$stored_filename" | grep -o "\(.*=[0-9.]*\)")
+  # Grep all parameter=value pairs
+  pairs=$(echo "$stored_filename" | grep -o "\(.*=[0-9.]*\)")
 
-f_sampling_index=$(echo "$pairs" | grep -o "f_sampling_index=[0-9.]*" | cut -d'=' -f2)
-lpf_index=$(echo "$pairs" | grep -o "lpf_index=[0-9.]*" | cut -d'=' -f2)
-f_center=$(echo "$pairs" | grep -o "f_center=[0-9.]*" | cut -d'=' -f2)
-gain=$(echo "$pairs" | grep -o "gain=[0-9.]*" | cut -d'=' -f2)
-timestamp=$(echo "$pairs" | grep -o "timestamp=[0-9.]*" | cut -d'=' -f2)
+  f_sampling_index=$(echo "$pairs" | grep -o "f_sampling_index=[0-9.]*" | cut -d'=' -f2)
+  lpf_index=$(echo "$pairs" | grep -o "lpf_index=[0-9.]*" | cut -d'=' -f2)
+  f_center=$(echo "$pairs" | grep -o "f_center=[0-9.]*" | cut -d'=' -f2)
+  gain=$(echo "$pairs" | grep -o "gain=[0-9.]*" | cut -d'=' -f2)
+  timestamp=$(echo "$pairs" | grep -o "timestamp=[0-9.]*" | cut -d'=' -f2)
+fi
 
 # Decode indexes into real values
 
@@ -40,4 +62,7 @@ MOTD="
   Gain:             $gain dB;
   
 "
-echo "$MOTD"
\ No newline at end of file
+echo "$MOTD"
+if [ -n "$metadata" ]; then
+  echo "  Metadata block:   $metadata"
+fi
\ No newline at end of file
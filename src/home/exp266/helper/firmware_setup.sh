@@ -22,6 +22,11 @@ else
     fi
 fi
 
+## Fast init: the devicetree is already applied (see record.sh), only the firmware version is checked
+if [[ "$1" == "skip_devicetree" ]]; then
+    echo "FPGA devicetree already applied, skipping"
+    exit 0
+fi
 
 cd /tmp
 ## Exp202 software (device tree)
@@ -0,0 +1,47 @@
+#!/usr/bin/env sh
+
+## List the recordings stored in the partition from the recording index (see write_metadata.sh), with a single read.
+## Usage: ./helper/list_recordings.sh [verify]
+## verify also reads every recording back and compares it against the checksum noted when it was stored.
+
+verify=$1
+
+## EMMC_IMAGE=<file> reads a p180 image instead of the eMMC, p180 falls back to its range of mmcblk0 (see stream_emmc.sh)
+if [ -n "$EMMC_IMAGE" ]; then
+    device=$EMMC_IMAGE
+    partition_block=0
+elif [ -b /dev/mmcblk0p180 ]; then
+    device=/dev/mmcblk0p180
+    partition_block=0
+else
+    device=/dev/mmcblk0
+    partition_block=13680640 # P180 start, 512-byte blocks
+fi
+
+index=$(dd if=$device bs=4096 skip=$(($partition_block / 8 + 47088)) count=16 2>/dev/null | tr -d '\000' | grep '^{"version":1,"slot":')
+if [ -z "$index" ]; then
+    echo "### No recordings in the index, use ./helper/peek_emmc.sh for recordings stored before it."
+    exit 1
+fi
+
+echo "### Stored recordings:"
+printf "%-4s %-19s %-10s %-10s %-10s %-10s %-10s %s\n" slot start record_mode carrier_GHz sampling_Hz size_MB cksum member
+echo "$index" | while read metadata; do
+    field() {
+        echo "$metadata" | sed -n "s/.*\"$1\":\"\{0,1\}\([^,\"}]*\).*/\1/p"
+    }
+    slot=$(field slot)
+    blocks=$(field blocks)
+    cksum=$(field cksum)
+    printf "%-4s %-19s %-10s %-10s %-10s %-10s %-10s %s\n" $slot "$(date -d @$(field start_epoch_s) +'%Y-%m-%d %H:%M:%S')" $(field record_mode) $(field carrier_GHz) $(field sampling_Hz) \
+        $(python3 -c "print(round(${blocks:-0}*512/(1024*1024), 1))") ${cksum:--} $(field member)
+
+    if [ "$verify" = "verify" ] && [ -n "$cksum" ]; then
+        stored=$(dd if=$device bs=512 skip=$(($partition_block + $(field block_offset))) count=$blocks 2>/dev/null | cksum | cut -d " " -f1)
+        if [ "$stored" = "$cksum" ]; then
+            echo "     checksum OK"
+        else
+            echo "     checksum MISMATCH: $stored"
+        fi
+    fi
+done
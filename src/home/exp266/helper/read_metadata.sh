@@ -0,0 +1,48 @@
+#!/usr/bin/env sh
+
+## Print the metadata of one recording stored by write_metadata.sh, or a single field of it, with one 64 KiB read of the index.
+## Usage: ./helper/read_metadata.sh [key] [slot]
+## Without a slot, or with slot "latest", the last recording stored is used. The slot of every recording is listed by list_recordings.sh.
+## Fails with 1 when there is no such recording, with 2 when its slot describes another recording than the one stored at its offset.
+
+key=$1
+slot=$2
+
+index_block=47088 # first 4 KiB block of the index, 16 slots at the end of P180 (192937984 bytes)
+index_slots=16
+
+## EMMC_IMAGE=<file> reads a p180 image instead of the eMMC, p180 falls back to its range of mmcblk0 (see stream_emmc.sh)
+if [ -n "$EMMC_IMAGE" ]; then
+    device=$EMMC_IMAGE
+    partition_block=0
+elif [ -b /dev/mmcblk0p180 ]; then
+    device=/dev/mmcblk0p180
+    partition_block=0
+else
+    device=/dev/mmcblk0
+    partition_block=13680640 # P180 start, 512-byte blocks
+fi
+
+# Every used slot holds one line of JSON followed by zeros, the slots are filled in order
+index=$(dd if=$device bs=4096 skip=$(($partition_block / 8 + $index_block)) count=$index_slots 2>/dev/null | tr -d '\000' | grep '^{"version":1,"slot":')
+if [ -z "$slot" ] || [ "$slot" = "latest" ]; then
+    metadata=$(echo "$index" | tail -n1)
+else
+    metadata=$(echo "$index" | grep "^{\"version\":1,\"slot\":$slot,")
+fi
+[ -n "$metadata" ] || exit 1
+
+field() {
+    echo "$metadata" | sed -n "s/.*\"$1\":\"\{0,1\}\([^,\"}]*\).*/\1/p"
+}
+
+# Name of the tar member at the offset of the recording, to tell stale metadata from a later recording apart
+block_offset=$(field block_offset)
+member=$(dd if=$device bs=512 skip=$(($partition_block + ${block_offset:-0})) count=1 2>/dev/null | head -c 100 | tr -d '\000')
+echo "$metadata" | grep -qF "\"member\":\"$member\"" || exit 2
+
+if [ -n "$key" ]; then
+    field $key
+else
+    echo "$metadata"
+fi
@@ -0,0 +1,77 @@
+#!/usr/bin/env sh
+
+## Print the samples of a stored recording straight from their byte range of the partition, without tar.
+## Usage: ./helper/read_range.sh [slot] [sample_offset] [sample_count] [segment]
+## The recording is located through the recording index (see list_recordings.sh), the latest one by default.
+## Without a segment every member of the recording is printed in order, like tar -xO, and the range applies to each of them.
+## Reads go in 1 MiB blocks, only the range asked for is read. The name of every member is printed to stderr, like tar -v.
+## The samples are read by bin/iq_read (dependencies/iq-read) when it is there, otherwise by dd.
+
+slot=${1:-latest}
+sample_offset=${2:-0}
+sample_count=$3
+segment=$4
+
+sample_size=4 #bytes
+block_size=1048576
+iq_read=$(dirname $0)/../bin/iq_read
+
+## EMMC_IMAGE=<file> reads a p180 image instead of the eMMC, p180 falls back to its range of mmcblk0 (see stream_emmc.sh)
+if [ -n "$EMMC_IMAGE" ]; then
+    device=$EMMC_IMAGE
+    partition_block=0
+elif [ -b /dev/mmcblk0p180 ]; then
+    device=/dev/mmcblk0p180
+    partition_block=0
+else
+    device=/dev/mmcblk0
+    partition_block=13680640 # P180 start, 512-byte blocks
+fi
+
+metadata=$($(dirname $0)/read_metadata.sh "" $slot)
+if [ -z "$metadata" ]; then
+    echo "No recording in slot $slot of the recording index" >&2
+    exit 1
+fi
+
+# Print the range of the member whose tar header is at block_offset
+read_member() {
+    local header_block=$1
+    local header=$(dd if=$device bs=512 skip=$(($partition_block + $header_block)) count=1 2>/dev/null | tr '\000' ' ')
+    local size=$((0$(echo "$header" | cut -c 125-136 | tr -d ' ')))
+    local first=$(($sample_offset * $sample_size))
+    [ $first -lt $size ] || return 0
+    echo "$(echo "$header" | cut -c 1-100 | sed 's/ *$//')" >&2
+
+    if [ -x $iq_read ]; then
+        $iq_read $device $((($partition_block + $header_block + 1) * 512)) $size $sample_offset $sample_count
+        return
+    fi
+
+    local length=$(($size - $first))
+    if [ -n "$sample_count" ] && [ $(($sample_count * $sample_size)) -lt $length ]; then
+        length=$(($sample_count * $sample_size))
+    fi
+
+    local start=$((($partition_block + $header_block + 1) * 512 + $first))
+    local lead=$(($start % $block_size))
+    dd if=$device bs=$block_size skip=$(($start / $block_size)) count=$((($lead + $length + $block_size - 1) / $block_size)) 2>/dev/null \
+        | tail -c +$(($lead + 1)) | head -c $length
+}
+
+# Rows of the segments table: [segment, epoch_s, block_offset, number_of_samples, carrier_frequency_GHz]
+segments=$(echo "$metadata" | sed -n 's/.*"segments":\[\[\(.*\)\]\].*/\1/p' | sed 's/\],\[/ /g')
+if [ -z "$segments" ]; then
+    read_member $(echo "$metadata" | sed -n 's/.*"block_offset":\([0-9]*\).*/\1/p')
+elif [ -n "$segment" ]; then
+    block_offset=$(echo $segments | tr " " "\n" | awk -F "," -v segment=$segment '$1 == segment { print $3 }')
+    if [ -z "$block_offset" ]; then
+        echo "No segment $segment in the recording" >&2
+        exit 1
+    fi
+    read_member $block_offset
+else
+    for row in $segments; do
+        read_member $(echo $row | cut -d "," -f3)
+    done
+fi
@@ -0,0 +1,29 @@
+#!/usr/bin/env sh
+
+## Sample the housekeeping temperatures next to a running capture, tagged with the sample index they belong to.
+## Usage: nice -n 19 ./helper/sample_telemetry.sh <output.csv> <interval_s> <sampling_Hz> <capture_state_file>
+## <capture_state_file> holds "<uptime> <segment>" while a capture runs, with the uptime at which it started, and is empty
+## otherwise. Each line carries the segment and the sample index within it, counted from there, both are empty between
+## captures (exp202 init, calibration, the wait between segments).
+## Temperatures are in millidegrees Celsius, one column per thermal zone and hwmon sensor found. Runs until killed.
+
+output_file=$1
+interval_s=$2
+sampling_Hz=$3
+capture_state_file=$4
+
+sensors=$(ls /sys/class/thermal/thermal_zone*/temp /sys/class/hwmon/hwmon*/temp*_input 2>/dev/null)
+
+echo "uptime_s,segment,sample_index$(for sensor in $sensors; do printf ",%s" $sensor; done)" > $output_file
+while true; do
+    now=$(cut -d " " -f1 /proc/uptime)
+    segment=
+    sample_index=
+    set -- $(cat $capture_state_file 2>/dev/null)
+    if [ -n "$2" ]; then
+        segment=$2
+        sample_index=$(awk "BEGIN {printf \"%d\", ($now - $1) * $sampling_Hz}")
+    fi
+    echo "$now,$segment,$sample_index$(for sensor in $sensors; do printf ",%s" $(cat $sensor); done)" >> $output_file
+    sleep $interval_s
+done
@@ -0,0 +1,85 @@
+#!/usr/bin/env sh
+
+## Map a time window or a sample range of a stored recording to the sample ranges to read, one line per segment:
+##   <segment> <sample_offset> <sample_count> <byte_offset> <gap_samples>
+## with the byte offset of the first sample from the partition start, and the time between the end of the range of the
+## line before and the start of this one, in samples. Feed the lines to read_range.sh.
+## Usage: ./helper/seek_window.sh <window> [slot]
+##   all        the whole recording
+##   2.5,4      seconds from the first sample of the recording, ex. the time span picked in the signal-picker
+##   2.5        from 2.5 seconds to the end of the recording
+##   samples:1000000,3000000
+##              sample range, counted over all segments of the recording, samples:1000000 up to the end
+## Fails with 1 when there is no such recording in the index, 2 when the index does not match it, 3 for a bad window.
+## Segments are placed in time by the epoch at which their capture started (10 ms resolution, see record.sh), a window over
+## the gap between two segments reads nothing there.
+
+window=${1:-all}
+slot=${2:-latest}
+
+metadata=$($(dirname $0)/read_metadata.sh "" $slot)
+if [ $? -eq 2 ]; then
+    echo "Slot $slot of the recording index does not match the stored recording" >&2
+    exit 2
+elif [ -z "$metadata" ]; then
+    echo "No recording in slot $slot of the recording index" >&2
+    exit 1
+fi
+
+field() {
+    echo "$metadata" | sed -n "s/.*\"$1\":\"\{0,1\}\([^,\"}]*\).*/\1/p"
+}
+
+# Narrowband recordings are stored at their output sampling rate
+sampling_Hz=$(field output_sampling_Hz)
+if [ -z "$sampling_Hz" ]; then
+    sampling_Hz=$(field sampling_Hz)
+fi
+number_of_samples=$(python3 -c "print(int($(field number_of_samples) * $sampling_Hz / $(field sampling_Hz)))")
+
+# Rows of the segments table: [segment, epoch_s, block_offset, number_of_samples, carrier_frequency_GHz],
+# a recording without segments is a single one
+segments=$(echo "$metadata" | sed -n 's/.*"segments":\[\[\(.*\)\]\].*/\1/p' | sed 's/\],\[/ /g')
+if [ -z "$segments" ]; then
+    segments="1,$(field start_epoch_s),$(field block_offset),$number_of_samples,$(field carrier_GHz)"
+fi
+
+case "$window" in
+    all) mode=samples; first=0; last=-1 ;;
+    samples:*) mode=samples; first=${window#samples:} ;;
+    *) mode=time; first=$window ;;
+esac
+# Without an end the window goes to the end of the recording
+if [ "$window" != "all" ]; then
+    case "$first" in
+        *,*) last=${first#*,}; first=${first%,*} ;;
+        *) last=-1 ;;
+    esac
+    if ! echo "$first,$last" | grep -qE '^[0-9.]+,(-1|[0-9.]+)$'; then
+        echo "Bad window $window, see the usage of $0" >&2
+        exit 3
+    fi
+fi
+
+echo $segments | tr " " "\n" | awk -F "," -v mode=$mode -v first=$first -v last=$last -v rate=$sampling_Hz '
+    NR == 1 { t0 = $2 }
+    {
+        if (mode == "time") {
+            # Segment start and end of the window in samples of this segment
+            from = int((first - ($2 - t0)) * rate)
+            to = (last < 0) ? $4 : int((last - ($2 - t0)) * rate)
+        } else {
+            from = first - position
+            to = (last < 0) ? $4 : last - position
+        }
+        position += $4
+        if (from < 0) from = 0
+        if (to > $4) to = $4
+        if (to <= from) next
+        # Time of the range from the start of the recording, in samples
+        start = ($2 - t0) * rate + from
+        gap = (printed && start > end) ? int(start - end) : 0
+        end = ($2 - t0) * rate + to
+        printed = 1
+        printf "%d %d %d %d %d\n", $1, from, to - from, ($3 + 1) * 512 + from * 4, gap
+    }'
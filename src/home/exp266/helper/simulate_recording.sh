@@ -0,0 +1,76 @@
+#!/usr/bin/env sh
+
+## Write a synthetic exp202 recording into a p180 image, so the storage and processing scripts can run on a plain Linux host.
+## Usage: EMMC_IMAGE=emmc_p180.img ./helper/simulate_recording.sh [samp_freq_index] [number_of_samples] [rate_limit_MBps]
+## Then run the other helpers (peek_emmc.sh, emmc_metadata.sh, ...) with the same EMMC_IMAGE exported.
+## The samples are noise from /dev/urandom. Set rate_limit_MBps to feed the writer at a fixed rate instead of as fast as possible.
+
+EMMC_IMAGE=${EMMC_IMAGE:-"emmc_p180.img"}
+samp_freq_index=${1:-0}
+number_of_samples=${2:-1000000}
+rate_limit_MBps=${3:-0}
+
+carrier_frequency_GHz=0.433550
+lpf_bw_cfg=15
+gain_db=60
+sample_size=4 #bytes
+samp_freq_index_lookup="1.5 1.75 3.5 3 3.84 5 5.5 6 7 8.75 10 12 14 20 24 28 32 36 40 60 76.8 80" # MHz
+
+#/usr/sbin/blkpg-part add /dev/mmcblk0 180 7004487680 192937984
+length=192937984
+
+if [ ! -e $EMMC_IMAGE ]; then
+    echo "Creating partition image $EMMC_IMAGE"
+    dd if=/dev/zero of=$EMMC_IMAGE bs=1048576 count=$(($length / 1048576))
+fi
+
+stored_filename=sdr_exp202-f_sampling_index=${samp_freq_index}-lpf_index=${lpf_bw_cfg}-f_center=${carrier_frequency_GHz}-gain=${gain_db}-timestamp=$(date +%s).cs16
+size=$(($number_of_samples*$sample_size))
+
+# Noise samples, with a rate limit one 1 MiB block per 1/rate seconds, as a paced DMA producer would deliver them
+generate_samples() {
+    if [ "$rate_limit_MBps" != "0" ]; then
+        local blocks=$((($size + 1048575) / 1048576))
+        local block_period=$(python3 -c "print(1/$rate_limit_MBps)")
+        local i=0
+        while [ $i -lt $blocks ]; do
+            head -c 1048576 /dev/urandom
+            sleep $block_period
+            i=$(($i+1))
+        done | head -c $size
+    else
+        head -c $size /dev/urandom
+    fi
+}
+
+# Same log lines as exp202, the benchmark times the capture by them
+echo "### Generating $number_of_samples samples into $EMMC_IMAGE: $stored_filename"
+echo "IQ capture: Starting..."
+record_start=$(date +%s)
+# Streamed like exp202 writes it: header, samples padded to 512 bytes, end-of-archive marker
+{
+    $(dirname $0)/tar_header.sh $stored_filename $size
+    generate_samples
+    head -c $(((512 - $size % 512) % 512 + 1024)) /dev/zero
+} | dd of=$EMMC_IMAGE bs=1048576 conv=notrunc 2>/dev/null
+echo "IQ capture: Finished"
+
+# Like record.sh with store_mode=overwrite: slot 0 at the partition start, both checksums in one read back
+blocks=$((1 + ($size + 511) / 512 + 2))
+chunks_fifo=$(mktemp -u)
+mkfifo $chunks_fifo
+$(dirname $0)/chunks.sh crc < $chunks_fifo > $chunks_fifo.crc &
+chunks_pid=$!
+cksum=$(dd if=$EMMC_IMAGE bs=512 count=$blocks 2>/dev/null | tee $chunks_fifo | cksum | cut -d " " -f1)
+wait $chunks_pid
+chunk_crc32=$(cat $chunks_fifo.crc)
+rm -f $chunks_fifo $chunks_fifo.crc
+$(dirname $0)/write_metadata.sh $EMMC_IMAGE clear
+
+sampling_Hz=$(python3 -c "print(round(float('$(echo $samp_freq_index_lookup | cut -d " " -f $(($samp_freq_index+1)))')*1000000))")
+$(dirname $0)/write_metadata.sh $EMMC_IMAGE 0 \
+    block_offset=0 blocks=$blocks cksum=$cksum chunk_crc32=\"$chunk_crc32\" \
+    member=$stored_filename format=cs16 record_mode=simulated \
+    samp_freq_index=$samp_freq_index sampling_Hz=$sampling_Hz lpf_index=$lpf_bw_cfg \
+    carrier_GHz=$carrier_frequency_GHz gain_dB=$gain_db number_of_samples=$number_of_samples \
+    start_epoch_s=$record_start end_epoch_s=$(date +%s) temperature_degC=null
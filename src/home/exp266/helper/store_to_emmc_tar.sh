@@ -45,8 +45,11 @@ copy_and_verify() {
     local destination_partition=$2
     # if [ "$predef_md5sum" == "$(md5sum $source_file | cut -d ' ' -f 1)" ]; then
         echo "Storing files:"
-        su - -c "cd $(dirname $source_file); /usr/sbin/gnu_tar.tar cvf /dev/mmcblk0p$destination_partition $(basename $source_file)"
-        echo 3 > /proc/sys/vm/drop_caches
+        # 1 MiB records (-b 2048) so the partition is written in large sequential chunks
+        su - -c "cd $(dirname $source_file); /usr/sbin/gnu_tar.tar -b 2048 -cvf /dev/mmcblk0p$destination_partition $(basename $source_file)"
+        # Write back and drop only the partition's cached pages, not the whole page cache. The listing below reads
+        # through /dev/mmcblk0, which caches separately, so its stale pages go too.
+        { blockdev --flushbufs /dev/mmcblk0p$destination_partition && blockdev --flushbufs /dev/mmcblk0; } || echo 3 > /proc/sys/vm/drop_caches
         # list files in stored tar
         echo "Stored to partition:"
         dd if=/dev/mmcblk0 bs=$bs skip=$start_add_512 count=$lenght_512 | gnu_tar.tar tv
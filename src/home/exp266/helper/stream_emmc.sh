@@ -2,4 +2,34 @@
 
 #$(dirname $0)/create_emmc_partition.sh
 
-dd if=/dev/mmcblk0 bs=512 skip=13680640 count=376832
\ No newline at end of file
+## Usage: ./helper/stream_emmc.sh [slot]
+## With a slot (or "latest") only that recording is streamed, located through the recording index (see list_recordings.sh),
+## otherwise the whole partition. Reads go in 1 MiB blocks, or 4 KiB blocks for a single recording (they are 4 KiB aligned).
+## To read the samples of a recording without tar, use read_range.sh.
+slot=$1
+
+## EMMC_IMAGE=<file> reads a p180 image instead of the eMMC, ex. on a host without the SEPP (see simulate_recording.sh)
+## Reads go through p180, the device record.sh writes to, so they share its page cache and never see stale blocks.
+## p180 is only there once create_emmc_partition.sh ran since boot, before that its range of mmcblk0 is read
+## (nothing was written through p180 since boot either, so nothing can be stale).
+if [ -n "$EMMC_IMAGE" ]; then
+    device=$EMMC_IMAGE
+    partition_block=0
+elif [ -b /dev/mmcblk0p180 ]; then
+    device=/dev/mmcblk0p180
+    partition_block=0
+else
+    device=/dev/mmcblk0
+    partition_block=13680640 # P180 start, 512-byte blocks
+fi
+
+if [ -n "$slot" ]; then
+    block_offset=$($(dirname $0)/read_metadata.sh block_offset $slot)
+    blocks=$($(dirname $0)/read_metadata.sh blocks $slot)
+fi
+
+if [ -n "$blocks" ]; then
+    dd if=$device bs=4096 skip=$((($partition_block + $block_offset) / 8)) count=$((($blocks + 7) / 8))
+else
+    dd if=$device bs=1048576 skip=$(($partition_block / 2048)) count=184
+fi
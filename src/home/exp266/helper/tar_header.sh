@@ -0,0 +1,24 @@
+#!/usr/bin/env sh
+
+## Print the 512-byte tar header of a member, for payloads that are streamed into the partition before their size is known.
+## Usage: ./helper/tar_header.sh <member_name> <size_in_bytes>
+
+member_name=$1
+size=$2
+
+if [ -z "$member_name" ] || [ -z "$size" ]; then
+    echo "Usage: $0 <member_name> <size_in_bytes>" >&2
+    exit 1
+fi
+
+# Longer names need an extra GNU long-name header block in front
+if [ ${#member_name} -gt 99 ]; then
+    echo "Member name longer than 99 characters: $member_name" >&2
+    exit 1
+fi
+
+work_dir=$(mktemp -d)
+# Sparse placeholder of the right size, tar stops being read after the header
+dd of=$work_dir/$member_name bs=1 count=0 seek=$size 2>/dev/null
+tar -C $work_dir -cf - $member_name 2>/dev/null | head -c 512
+rm -r $work_dir
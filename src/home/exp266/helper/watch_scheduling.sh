@@ -0,0 +1,25 @@
+#!/usr/bin/env sh
+
+## Keep the latest scheduler statistics of every thread of a running binary, for the scheduling latency report of record.sh.
+## Usage: ./helper/watch_scheduling.sh <binary_name> <snapshot_file>
+## Waits for the binary to start and returns once it has exited. Every line of <snapshot_file> is
+## "<thread_id> <cpu_time_ns> <runqueue_wait_ns> <timeslices>" (/proc/<pid>/task/<tid>/schedstat).
+
+binary_name=$1
+snapshot_file=$2
+
+pid=
+while [ -z "$pid" ]; do
+    pid=$(pidof $binary_name)
+    sleep 0.1
+done
+
+while [ -e /proc/$pid ]; do
+    for task in /proc/$pid/task/*; do
+        [ -e $task/schedstat ] && echo "$(basename $task) $(cat $task/schedstat)"
+    done > $snapshot_file.tmp 2>/dev/null
+    # Keep the previous snapshot when the process exited halfway through this one
+    [ -s $snapshot_file.tmp ] && mv $snapshot_file.tmp $snapshot_file
+    sleep 0.5
+done
+rm -f $snapshot_file.tmp
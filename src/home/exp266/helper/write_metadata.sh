@@ -0,0 +1,53 @@
+#!/usr/bin/env sh
+
+## Store the metadata of one recording as one line of compact JSON in its 4 KiB slot of the recording index,
+## the last 64 KiB of the partition, so every action can list the stored recordings with a single read
+## instead of scanning the tar (see read_metadata.sh and list_recordings.sh).
+## Usage: ./helper/write_metadata.sh <recording_path> <slot> key=value [key=value ...]
+##        ./helper/write_metadata.sh <recording_path> clear
+## Numbers, null, JSON arrays and values already in double quotes are stored as they are, everything else as a string.
+## clear empties the whole index, when the partition is about to be overwritten from its start.
+
+recording_path=$1
+slot=$2
+shift 2
+
+index_block=47088 # first 4 KiB block of the index, 16 slots at the end of P180 (192937984 bytes)
+index_slots=16
+
+if [ -z "$recording_path" ] || [ -z "$slot" ]; then
+    echo "Usage: $0 <recording_path> <slot> key=value [key=value ...]"
+    echo "       $0 <recording_path> clear"
+    exit 1
+fi
+
+if [ "$slot" = "clear" ]; then
+    dd if=/dev/zero of=$recording_path bs=4096 seek=$index_block count=$index_slots conv=notrunc 2>/dev/null
+    echo "Recording index cleared"
+    exit 0
+fi
+
+if [ $slot -ge $index_slots ]; then
+    echo "No slot $slot in the recording index, it holds $index_slots recordings"
+    exit 1
+fi
+
+json="{\"version\":1,\"slot\":$slot"
+for pair in "$@"; do
+    key=${pair%%=*}
+    value=${pair#*=}
+    if echo "$value" | grep -qE '^-?[0-9]+(\.[0-9]+)?$|^null$|^\[|^"'; then
+        json="$json,\"$key\":$value"
+    else
+        json="$json,\"$key\":\"$value\""
+    fi
+done
+json="$json}"
+
+if [ ${#json} -gt 4095 ]; then
+    echo "Metadata does not fit into 4 KiB, not stored: $json"
+    exit 1
+fi
+
+{ printf "%s\n" "$json"; head -c $((4095 - ${#json})) /dev/zero; } | dd of=$recording_path bs=4096 seek=$(($index_block + $slot)) count=1 conv=notrunc 2>/dev/null
+echo "Metadata: $json"
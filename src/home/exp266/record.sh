@@ -23,6 +23,23 @@ gain_db=$(awk -F "=" '/gain_db/ {printf "%s",$2}' $CONFIG_FILE)
 number_of_samples=$(awk -F "=" '/number_of_samples/ {printf "%s",$2}' $CONFIG_FILE)
 calibrate_frontend=$(awk -F "=" '/calibrate_frontend/ {printf "%s",$2}' $CONFIG_FILE)
 RECORDING_PATH=$(awk -F "=" '/recording_path/ {printf "%s",$2}' $CONFIG_FILE)
+record_mode=$(awk -F "=" '/record_mode/ {printf "%s",$2}' $CONFIG_FILE)
+downsample_shift=$(awk -F "=" '/downsample_shift/ {printf "%s",$2}' $CONFIG_FILE)
+downsample_cutoff_frequency=$(awk -F "=" '/downsample_cutoff_frequency/ {printf "%s",$2}' $CONFIG_FILE)
+segment_count=$(awk -F "=" '/segment_count/ {printf "%s",$2}' $CONFIG_FILE)
+segment_period_s=$(awk -F "=" '/segment_period_s/ {printf "%s",$2}' $CONFIG_FILE)
+auto_gain=$(awk -F "=" '/auto_gain/ {printf "%s",$2}' $CONFIG_FILE)
+agc_target_dBFS=$(awk -F "=" '/agc_target_dBFS/ {printf "%s",$2}' $CONFIG_FILE)
+capture_cpu=$(awk -F "=" '/capture_cpu/ {printf "%s",$2}' $CONFIG_FILE)
+capture_rt_priority=$(awk -F "=" '/capture_rt_priority/ {printf "%s",$2}' $CONFIG_FILE)
+telemetry_interval_s=$(awk -F "=" '/telemetry_interval_s/ {printf "%s",$2}' $CONFIG_FILE)
+fast_init=$(awk -F "=" '/fast_init/ {printf "%s",$2}' $CONFIG_FILE)
+sweep_frequencies_GHz=$(awk -F "=" '/sweep_frequencies_GHz/ {printf "%s",$2}' $CONFIG_FILE | tr "," " ")
+store_mode=$(awk -F "=" '/store_mode/ {printf "%s",$2}' $CONFIG_FILE)
+wipe_partition=$(awk -F "=" '/wipe_partition/ {printf "%s",$2}' $CONFIG_FILE)
+trigger_threshold_dB=$(awk -F "=" '/trigger_threshold_dB/ {printf "%s",$2}' $CONFIG_FILE)
+trigger_pre_s=$(awk -F "=" '/trigger_pre_s/ {printf "%s",$2}' $CONFIG_FILE)
+trigger_post_s=$(awk -F "=" '/trigger_post_s/ {printf "%s",$2}' $CONFIG_FILE)
 
 ## MOTD
 
@@ -33,6 +50,76 @@ sampling_realvalue=$(echo $samp_freq_index_lookup | cut -d " " -f $(($samp_freq_
 lpf_realvalue=$(echo $lpf_bw_cfg_lookup | cut -d " " -f $(($lpf_bw_cfg+1)))
 
 
+capture_path=$RECORDING_PATH
+sampling_Hz=$(python3 -c "print(round($sampling_realvalue*1000000))")
+if [[ $record_mode == narrowband ]]; then
+  # exp202 writes its tar stream into a pipe, only the mixed and decimated product reaches the partition
+  capture_path=/tmp/exp266_capture.fifo
+  decimation_rate=$(python3 -c "print(int($sampling_Hz/$downsample_cutoff_frequency))")
+  output_sample_rate=$(python3 -c "print(int($sampling_Hz/$decimation_rate))")
+fi
+if [[ $record_mode == triggered ]]; then
+  # exp202 writes its tar stream into a pipe, only the windows around detected signals reach the partition
+  capture_path=/tmp/exp266_capture.fifo
+  if [ ! -x $BINARY_PATH/iq_trigger ]; then
+    echo "#### $BINARY_PATH/iq_trigger is missing, build it with dependencies/sepp_build/build-iq-tools.sh!"
+    exit 1
+  fi
+fi
+if [[ $record_mode == segmented ]] || [[ $record_mode == sweep ]]; then
+  # Every segment is written behind the previous one, so exp202 writes into a pipe instead of the partition start
+  capture_path=/tmp/exp266_capture.fifo
+fi
+
+## Place the recording in the store
+# overwrite: slot 0 at the partition start, the index is cleared before recording.
+# append: the next slot of the recording index, behind the last recording (4 KiB aligned). Refused when the last
+# entry of the index does not match the partition content, appending would then clear the index and overwrite it.
+partition_blocks=376704 # P180 size in 512-byte blocks, without the recording index
+index_slots=16
+store_slot=0
+base_block=0
+if [[ $store_mode == append ]] && [[ $wipe_partition != true ]]; then
+  $EXP_PATH/helper/create_emmc_partition.sh > /dev/null
+  last_slot=$($EXP_PATH/helper/read_metadata.sh slot)
+  if [ $? -eq 2 ]; then
+    echo "#### The last recording of the index does not match the partition content, refusing to append!"
+    echo "#### Check it with ./helper/list_recordings.sh verify, then switch store_mode to overwrite or wipe the partition."
+    exit 12
+  fi
+  if [ -n "$last_slot" ]; then
+    last_end=$(($($EXP_PATH/helper/read_metadata.sh block_offset) + $($EXP_PATH/helper/read_metadata.sh blocks)))
+    store_slot=$(($last_slot + 1))
+    base_block=$((($last_end + 7) / 8 * 8))
+  fi
+fi
+if [ $base_block -gt 0 ]; then
+  # exp202 can only write from the start of the output, so the archive goes through the segment writer
+  capture_path=/tmp/exp266_capture.fifo
+fi
+
+# Size of the archive in 512-byte blocks: header and padded samples of every member, end-of-archive marker
+segment_blocks=$((1 + ($number_of_samples * 4 + 511) / 512))
+if [[ $record_mode == narrowband ]]; then
+  expected_blocks=$((1 + ($number_of_samples * 4 / $decimation_rate + 511) / 512 + 2))
+elif [[ $record_mode == segmented ]]; then
+  expected_blocks=$(($segment_count * $segment_blocks + 2))
+elif [[ $record_mode == sweep ]]; then
+  expected_blocks=$(($(echo $sweep_frequencies_GHz | wc -w) * $segment_blocks + 2))
+else
+  expected_blocks=$(($segment_blocks + 2))
+fi
+archive_blocks=$expected_blocks
+
+if [ $store_slot -ge $index_slots ]; then
+  echo "#### All $index_slots slots of the recording index are used, switch store_mode to overwrite or wipe the partition!"
+  exit 12
+fi
+if [ $(($base_block + $expected_blocks)) -gt $partition_blocks ]; then
+  echo "#### The recording ($expected_blocks blocks from block $base_block) does not fit into the partition!"
+  exit 12
+fi
+
 MOTD="
 
   Center frequency: $carrier_frequency_GHz GHz $(python3 -c "print($carrier_frequency_GHz*1000)")MHz;
@@ -40,6 +127,8 @@ MOTD="
   Low Pass filter:  $lpf_realvalue MHz (id: $lpf_bw_cfg);
   Gain:             $gain_db dB;
   Calibrate:        $calibrate_frontend
+  Record mode:      ${record_mode:-full}
+  Store:            ${store_mode:-overwrite}, slot $store_slot at block $base_block
 
   Recording path:   $RECORDING_PATH
   Output path:      $OUTPUT_PATH
@@ -48,6 +137,18 @@ MOTD="
   
 "
 echo "$MOTD"
+if [[ $record_mode == narrowband ]]; then
+  echo "  Narrowband:       shift $downsample_shift Hz, cutoff $downsample_cutoff_frequency Hz, stored at $output_sample_rate Hz (size divided by $decimation_rate)"
+fi
+if [[ $record_mode == triggered ]]; then
+  echo "  Trigger:          $trigger_threshold_dB dB above the noise floor, keeping $trigger_pre_s s before and $trigger_post_s s after"
+fi
+if [[ $record_mode == segmented ]]; then
+  echo "  Segments:         $segment_count x $number_of_samples samples, one every $segment_period_s s"
+fi
+if [[ $record_mode == sweep ]]; then
+  echo "  Sweep:            $number_of_samples samples at each of $sweep_frequencies_GHz GHz"
+fi
 
 # Generate running config for exp202
 CONFIG="[SEPP_SDR_RX]
@@ -57,31 +158,346 @@ lpf_bw_cfg = $lpf_bw_cfg
 gain_db = $gain_db
 number_of_samples = $number_of_samples
 calibrate_frontend = $calibrate_frontend
-output_path = $RECORDING_PATH"
+output_path = $capture_path"
 
 echo "$CONFIG" > running_config.ini
 
+startup_report=$EXP_PATH/startup_report.txt
+rm -f $startup_report
+
+# Note the uptime at which a startup step is reached
+profile_step() {
+  echo "$(cut -d " " -f1 /proc/uptime) $1" >> $startup_report
+}
+
+capture_start_file=/tmp/exp266_capture.start
+# "<start uptime> <segment>" while exp202 captures, empty otherwise, for the telemetry sampler
+capture_state_file=/tmp/exp266_capture.state
+
+## Thread placement
+# exp202 gets its own core (and SCHED_FIFO), everything else started from here - eMMC writers, DSP stages,
+# samplers - inherits the other core of the dual-core SEPP from this shell.
+capture_launcher=
+if [ -n "$capture_cpu" ]; then
+  taskset -p -c $((1 - $capture_cpu)) $$ > /dev/null
+  capture_launcher="taskset -c $capture_cpu"
+  if [ -n "$capture_rt_priority" ] && [ "$capture_rt_priority" != "0" ]; then
+    capture_launcher="$capture_launcher chrt -f $capture_rt_priority"
+  fi
+fi
+
+# Scheduler delay of every exp202 thread over its whole run, from the last watch_scheduling.sh snapshot
+write_scheduling_report() {
+  local snapshot_file=$1
+  if [ ! -s $snapshot_file ]; then
+    echo "#### Scheduling latency: not available (no /proc/<pid>/schedstat)"
+    return
+  fi
+  echo "#### Scheduling latency of $exp202_binary threads (${capture_launcher:-no pinning}):"
+  awk '{ printf "  thread %s: runqueue wait %.1f ms in %d timeslices, %.1f us on average\n", $1, $3 / 1000000, $4, ($4 > 0) ? $3 / $4 / 1000 : 0 }' $snapshot_file | tee -a $OUTPUT_PATH/scheduling_report.txt
+  rm -f $snapshot_file
+}
+
+# Run exp202, noting when each of its SDR init steps is reached and when the capture starts
+run_exp202() {
+  local status_file=/tmp/exp266_exp202.status
+  local schedstat_file=/tmp/exp266_exp202.schedstat
+  $EXP_PATH/helper/watch_scheduling.sh $exp202_binary $schedstat_file &
+  local watch_pid=$!
+  { $capture_launcher $BINARY_PATH/$exp202_binary $EXP_PATH/running_config.ini && echo 0 > $status_file || echo $? > $status_file; } 2>&1 | while read line; do
+    echo "$line"
+    profile_step "exp202: $line"
+    case "$line" in
+      *"IQ capture: Starting"*)
+        cut -d " " -f1 /proc/uptime > $capture_start_file
+        # segment is the one of record_segmented or record_sweep, when called from there
+        echo "$(cat $capture_start_file) ${segment:-1}" > $capture_state_file
+        ;;
+      *"IQ capture: Finished"*) : > $capture_state_file ;;
+    esac
+  done
+  : > $capture_state_file
+  kill $watch_pid 2>/dev/null || true
+  write_scheduling_report $schedstat_file
+  local status=$(cat $status_file)
+  rm -f $status_file
+  return $status
+}
+
+# Print every step relative to the start of record.sh and how long it took until the first IQ sample
+write_startup_report() {
+  echo "#### Startup report:"
+  awk 'NR == 1 { t0 = $1 } { $1 = sprintf("%8.2f s", $1 - t0); print }' $startup_report | tee $OUTPUT_PATH/startup_report.txt
+  echo "#### Time to first sample: $(awk 'NR == 1 { t0 = $1 } /IQ capture: Starting/ { printf "%.2f", $1 - t0; exit }' $startup_report) s"
+  rm $startup_report
+}
+
+# Store the parameters, location and checksum of the recording in its slot of the recording index (see helper/write_metadata.sh)
+# Write back and drop the recording from the page cache so it does not pin SEPP RAM. /dev/mmcblk0 has a page cache
+# of its own, drop it too so nothing reading p180 through the whole disk gets blocks from before this recording.
+write_back() {
+  { blockdev --flushbufs $RECORDING_PATH && blockdev --flushbufs /dev/mmcblk0; } || { sync; echo 3 > /proc/sys/vm/drop_caches; }
+}
+
+write_recording_metadata() {
+  # Read back from the eMMC once the page cache is written back and dropped, so the checksums cover what was
+  # actually written. The CRC of every 1 MiB chunk (see helper/chunks.sh) is taken in the same pass.
+  write_back
+  local member=$(dd if=$RECORDING_PATH bs=512 skip=$base_block count=1 2>/dev/null | head -c 100 | tr -d '\000')
+  echo "#### Checksumming the stored recording ($archive_blocks blocks)"
+  local chunks_fifo=/tmp/exp266_chunks.fifo
+  rm -f $chunks_fifo
+  mkfifo $chunks_fifo
+  $EXP_PATH/helper/chunks.sh crc < $chunks_fifo > /tmp/exp266_chunks.crc &
+  local chunks_pid=$!
+  local cksum=$(dd if=$RECORDING_PATH bs=512 skip=$base_block count=$archive_blocks 2>/dev/null | tee $chunks_fifo | cksum | cut -d " " -f1)
+  wait $chunks_pid
+  local chunk_crc32=$(cat /tmp/exp266_chunks.crc)
+  rm -f $chunks_fifo /tmp/exp266_chunks.crc
+  local temperature=$(sed -n 's/.*temperature = \([-0-9.]*\).*/\1/p' $OUTPUT_PATH/startup_report.txt | head -n1)
+  local final_gain_db=$(awk -F " = " '/gain_db/ {printf "%s",$2}' $EXP_PATH/running_config.ini)
+  local mode_fields=
+  if [[ $record_mode == narrowband ]]; then
+    mode_fields="f_shift_Hz=$downsample_shift output_sampling_Hz=$output_sample_rate"
+  fi
+  if [[ $record_mode == triggered ]]; then
+    mode_fields="trigger_threshold_dB=$trigger_threshold_dB trigger_windows=$(($(wc -l < $OUTPUT_PATH/trigger_events.csv) - 1))"
+  fi
+  if [ -e $OUTPUT_PATH/segments.csv ]; then
+    # Rows of segments.csv: [segment, epoch_s, block_offset, number_of_samples, carrier_frequency_GHz]
+    mode_fields="segments=[$(awk -F "," 'NR > 1 { printf "%s[%s,%s,%s,%s,%s]", (NR > 2) ? "," : "", $1, $2, $3, $4, $5 }' $OUTPUT_PATH/segments.csv)]"
+  fi
+  local carrier_GHz=$carrier_frequency_GHz
+  if [[ $record_mode == sweep ]]; then
+    # The carrier of every segment in order, carrier_GHz is the one of the first segment
+    carrier_GHz=$(echo $sweep_frequencies_GHz | cut -d " " -f1)
+    mode_fields="$mode_fields carriers_GHz=[$(echo $sweep_frequencies_GHz | tr " " ",")]"
+  fi
+
+  local fields="block_offset=$base_block blocks=$archive_blocks cksum=$cksum \
+    member=$member format=cs16 record_mode=${record_mode:-full} \
+    samp_freq_index=$samp_freq_index sampling_Hz=$sampling_Hz lpf_index=$lpf_bw_cfg \
+    carrier_GHz=$carrier_GHz gain_dB=$final_gain_db number_of_samples=$number_of_samples \
+    start_epoch_s=$record_start end_epoch_s=$(date +%s) temperature_degC=${temperature:-null} $mode_fields"
+
+  # The samples are already stored, a slot that does not fit must not stop record.sh: the chunk checksums are
+  # left out first (they still go down in chunk_crc32.txt), then the recording is only reported as not indexed.
+  if ! $EXP_PATH/helper/write_metadata.sh $RECORDING_PATH $store_slot $fields chunk_crc32=\"$chunk_crc32\"; then
+    echo "$chunk_crc32" | sed 's/.\{8\}/&\n/g' > $OUTPUT_PATH/chunk_crc32.txt
+    $EXP_PATH/helper/write_metadata.sh $RECORDING_PATH $store_slot $fields \
+      || echo "#### The recording is stored but not entered into the recording index!"
+  fi
+}
+
+# Copy a FIFO into the partition from a 512-byte block offset. The first dd only moves the shared offset,
+# the second gathers the pipe reads (64 KiB at most) into 1 MiB writes.
+write_to_partition() {
+  local fifo=$1
+  local block_offset=$2
+  { dd bs=512 seek=$block_offset count=0 conv=notrunc 2>/dev/null; dd ibs=65536 obs=1048576 conv=notrunc 2>/dev/null; } < $fifo 1<> $RECORDING_PATH
+}
+
+# Mix and decimate the samples of the capture
+narrowband_product() {
+  $BINARY_PATH/iq_toolbox/iq_mix -s $sampling_Hz -m $downsample_shift | $BINARY_PATH/iq_toolbox/iq_decimate -s $sampling_Hz -f $downsample_cutoff_frequency
+}
+
+# Keep only the windows around blocks above the noise floor, with their pre-trigger history (see dependencies/iq-trigger).
+# Where every window came from in the capture goes into trigger_events.csv in the output folder.
+triggered_product() {
+  $BINARY_PATH/iq_trigger -t $trigger_threshold_dB -e $OUTPUT_PATH/trigger_events.csv \
+    -p $(python3 -c "print(int($trigger_pre_s*$sampling_Hz))") -w $(python3 -c "print(int($trigger_post_s*$sampling_Hz))")
+}
+
+# Process the capture as it arrives with the given product function and stream the product into the partition
+# as a single tar member
+record_product() {
+  local stored_filename=$1
+  local product=$2
+  local product_fifo=/tmp/exp266_product.fifo
+  local product_size=/tmp/exp266_product.size
+
+  rm -f $capture_path $product_fifo
+  mkfifo $capture_path $product_fifo
+  capture_fifos="$capture_path $product_fifo"
+
+  # Payload goes right after the header block, the header is written once the size is known
+  write_to_partition $product_fifo $(($base_block + 1)) &
+  local writer_pid=$!
+  tar -xO < $capture_path | $product | tee $product_fifo | wc -c > $product_size &
+  local dsp_pid=$!
+
+  run_exp202
+  wait $dsp_pid
+  wait $writer_pid
+
+  local size=$(cat $product_size)
+  echo "#### Product: $stored_filename ($size bytes)"
+  $EXP_PATH/helper/tar_header.sh $stored_filename $size | dd of=$RECORDING_PATH bs=512 seek=$base_block count=1 conv=notrunc 2>/dev/null
+  # End-of-archive marker after the padded payload
+  archive_blocks=$((1 + ($size + 511) / 512 + 2))
+  dd if=/dev/zero of=$RECORDING_PATH bs=512 seek=$(($base_block + $archive_blocks - 2)) count=2 conv=notrunc 2>/dev/null
+
+  rm -f $capture_path $product_fifo $product_size
+  capture_fifos=
+}
+
+# Stream one exp202 tar archive into the partition at a 512-byte block offset
+record_segment() {
+  local block_offset=$1
+
+  rm -f $capture_path
+  mkfifo $capture_path
+  capture_fifos=$capture_path
+  write_to_partition $capture_path $block_offset &
+  local writer_pid=$!
+  run_exp202
+  wait $writer_pid
+  rm -f $capture_path
+  capture_fifos=
+}
+
+# Epoch [s] at which the last exp202 run printed "IQ capture: Starting", from the uptime noted by run_exp202,
+# so segments are placed in time by their first sample and not by when their exp202 init started
+capture_start_epoch() {
+  python3 -c "import time; print('%.2f' % (time.time() - $(cut -d " " -f1 /proc/uptime) + $(cat $capture_start_file)))"
+}
+
+segments_file=$EXP_PATH/segments.csv
+
+# Record segment_count segments back to back in the partition, each one overwriting the end-of-archive
+# marker of the previous one, so the recording stays a single tar with one member per segment.
+# Every segment is a new exp202 run, which resets the front end, so each one is calibrated as configured.
+record_segmented() {
+  echo "segment,epoch_s,block_offset,number_of_samples,carrier_frequency_GHz" > $segments_file
+  local block_offset=$base_block
+  local segment=1
+  while [ $segment -le $segment_count ]; do
+    local segment_start=$(date +%s)
+    echo "#### Segment $segment/$segment_count (block $block_offset)"
+    record_segment $block_offset
+    echo "$segment,$(capture_start_epoch),$block_offset,$number_of_samples,$carrier_frequency_GHz" >> $segments_file
+
+    block_offset=$(($block_offset + $segment_blocks))
+    if [ $segment -lt $segment_count ]; then
+      local wait_s=$(($segment_start + $segment_period_s - $(date +%s)))
+      if [ $wait_s -gt 0 ]; then
+        sleep $wait_s
+      else
+        echo "#### Segment took longer than the period of $segment_period_s s, starting the next one right away."
+      fi
+    fi
+    segment=$(($segment+1))
+  done
+  mv $segments_file $OUTPUT_PATH/
+}
+
+# Dwell number_of_samples on every carrier of the sweep list, one segment per carrier, back to back.
+# Retuning goes through the full exp202 init, which resets the front end, so every carrier is calibrated as configured.
+record_sweep() {
+  local count=$(echo $sweep_frequencies_GHz | wc -w)
+  echo "segment,epoch_s,block_offset,number_of_samples,carrier_frequency_GHz" > $segments_file
+  local block_offset=$base_block
+  local segment=1
+  for carrier in $sweep_frequencies_GHz; do
+    echo "#### Dwell $segment/$count at $carrier GHz (block $block_offset)"
+    sed -i "s/^carrier_frequency_GHz = .*/carrier_frequency_GHz = $carrier/" $EXP_PATH/running_config.ini
+    record_segment $block_offset
+    echo "$segment,$(capture_start_epoch),$block_offset,$number_of_samples,$carrier" >> $segments_file
+
+    block_offset=$(($block_offset + $segment_blocks))
+    segment=$(($segment+1))
+  done
+  mv $segments_file $OUTPUT_PATH/
+}
+
+# When record.sh stops early (set -e), ex. exp202 failing before it opened its output, the readers of the capture
+# FIFOs are still blocked opening them. Opening a FIFO read-write never blocks and lets them see the end of the
+# stream, so no background job is left holding the log pipe of start_exp266.sh. The telemetry sampler is stopped too.
+capture_fifos=
+telemetry_pid=
+cleanup() {
+  if [ -n "$telemetry_pid" ]; then
+    kill $telemetry_pid 2>/dev/null
+  fi
+  for fifo in $capture_fifos; do
+    if [ -p $fifo ]; then
+      : <> $fifo
+    fi
+  done
+}
+trap cleanup EXIT
+
 set -e
+profile_step "Setup started"
 
 ## Setup FPGA firmware - devicetree
 echo "#### Setup FPGA firmware - devicetree."
-$EXP_PATH/helper/firmware_setup.sh
+if [[ $fast_init == true ]] && [ -e /dev/uio2 ]; then
+  $EXP_PATH/helper/firmware_setup.sh skip_devicetree
+else
+  $EXP_PATH/helper/firmware_setup.sh
+fi
+profile_step "FPGA firmware ready"
 
 ## Setup eMMC partition
 echo "#### Setup eMMC partition."
-wipe_partition=$(awk -F "=" '/wipe_partition/ {printf "%s",$2}' $CONFIG_FILE)
 if [[ $wipe_partition == true ]]; then
     echo "#### Wiping partition clean. It make take a while, account for this in planning!"
     $EXP_PATH/helper/create_emmc_partition.sh wipe_partition
     else
     $EXP_PATH/helper/create_emmc_partition.sh
 fi
+if [ $store_slot -eq 0 ]; then
+  $EXP_PATH/helper/write_metadata.sh $RECORDING_PATH clear
+fi
+profile_step "eMMC partition ready"
+
+## Pick the gain
+if [[ $auto_gain == true ]]; then
+  echo "#### Auto gain pre-pass."
+  $EXP_PATH/helper/auto_gain.sh $EXP_PATH/running_config.ini $agc_target_dBFS
+  profile_step "Auto gain done"
+fi
 
 ## Start recording
 echo "#### Start Recording."
+record_start=$(date +%s)
+rm -f $capture_start_file
+: > $capture_state_file
+if [ -n "$telemetry_interval_s" ] && [ "$telemetry_interval_s" != "0" ]; then
+  # Lowest priority, the sampler must not delay the capture. The sample index counts stored samples, which narrowband
+  # recordings hold at the output rate.
+  telemetry_sampling_Hz=$sampling_Hz
+  if [[ $record_mode == narrowband ]]; then
+    telemetry_sampling_Hz=$output_sample_rate
+  fi
+  nice -n 19 $EXP_PATH/helper/sample_telemetry.sh $OUTPUT_PATH/telemetry.csv $telemetry_interval_s $telemetry_sampling_Hz $capture_state_file > /dev/null 2>&1 &
+  telemetry_pid=$!
+fi
 #export LD_PRELOAD="$LIB_PATH/libfftw3.so.3;$LIB_PATH/libsdr_api.so;$LIB_PATH/libsepp_api_core.so;$LIB_PATH/libsepp_ic.so"
-$BINARY_PATH/$exp202_binary $EXP_PATH/running_config.ini
+if [[ $record_mode == narrowband ]]; then
+  record_product sdr_exp266_nb-f_center=${carrier_frequency_GHz}-f_shift=${downsample_shift}-f_sampling=${output_sample_rate}-timestamp=$(date +%s).cs16 narrowband_product
+elif [[ $record_mode == triggered ]]; then
+  record_product sdr_exp266_trig-f_sampling_index=${samp_freq_index}-lpf_index=${lpf_bw_cfg}-f_center=${carrier_frequency_GHz}-gain=${gain_db}-timestamp=$(date +%s).cs16 triggered_product
+elif [[ $record_mode == segmented ]]; then
+  record_segmented
+elif [[ $record_mode == sweep ]]; then
+  record_sweep
+elif [ $base_block -gt 0 ]; then
+  record_segment $base_block
+else
+  run_exp202
+fi
+if [ -n "$telemetry_pid" ]; then
+  kill $telemetry_pid || true
+  telemetry_pid=
+fi
+rm -f $capture_start_file $capture_state_file
+write_startup_report
+write_recording_metadata
 tar --append --list -f $EXP_PATH/running_config.ini $RECORDING_PATH
+write_back
 mv $EXP_PATH/running_config.ini $OUTPUT_PATH/
 #export LD_PRELOAD=""
 
@@ -92,7 +508,7 @@ echo "#### Recording finished! File: $RECORDING_PATH"
 waterfall_render=$(awk -F "=" '/waterfall_render/ {printf "%s",$2}' $CONFIG_FILE)
 if [[ $waterfall_render == true ]]; then
   echo "#### Generate the waterfall."
-  $EXP_PATH/waterfall.sh $RECORDING_PATH $OUTPUT_PATH
+  $EXP_PATH/waterfall.sh $RECORDING_PATH $OUTPUT_PATH "" $store_slot all
   waterfall_name=$(ls -rt $OUTPUT_PATH/ | tail -n1)
   echo "#### Waterfall generated: $waterfall_name"
 fi
@@ -7,7 +7,7 @@ EXP_PATH=$(dirname $0)
 BINARY_PATH=$EXP_PATH/bin
 LIB_PATH=$EXP_PATH/lib
 CONFIG_FILE=$EXP_PATH/config.ini
-RECORDING_PATH=/dev/mmcblk0p180
+RECORDING_PATH=${EMMC_IMAGE:-/dev/mmcblk0p180}
 DATE=$(date +"%Y%m%d_%H%M%S")
 
 IN_FILE=${1:-$RECORDING_PATH}
@@ -19,16 +19,52 @@ waterfall_fft_size=$(awk -F "=" '/waterfall_fft_size/ {printf "%s",$2}' $CONFIG_
 waterfall_convert_to_jpg=$(awk -F "=" '/waterfall_convert_to_jpg/ {printf "%s",$2}' $CONFIG_FILE)
 
 FFT=${3:-"$waterfall_fft_size"}
+recording_slot=${4:-$(awk -F "=" '/recording_slot/ {printf "%s",$2}' $CONFIG_FILE)}
+processing_window=${5:-$(awk -F "=" '/processing_window/ {printf "%s",$2}' $CONFIG_FILE)}
 
 $EXP_PATH/helper/create_emmc_partition.sh
 
 echo "### Generating waterfall"
 FILENAME=renderfall_${waterfall_window}_${FFT}_${DATE}
-ARGUMENTS="$IN_FILE --format int16 --fftsize $FFT --window $waterfall_window --outfile $OUT_FOLDER/$FILENAME.png"
-echo "$BINARY_PATH/renderfall $ARGUMENTS"
+ARGUMENTS="--format int16 --fftsize $FFT --window $waterfall_window --outfile $OUT_FOLDER/$FILENAME.png"
+INPUT=$IN_FILE
+# Render only the processing window of the selected recording of the partition (see helper/seek_window.sh)
+if [ "$IN_FILE" = "$RECORDING_PATH" ]; then
+    # Recordings stored before the recording index are not in it, the whole partition is rendered for them
+    ranges=$($EXP_PATH/helper/seek_window.sh "$processing_window" "$recording_slot")
+    status=$?
+    if [ $status -gt 1 ]; then
+        exit 1
+    elif [ $status -eq 0 ] && [ -z "$ranges" ]; then
+        echo "#### No samples of slot ${recording_slot:-latest} in the window ${processing_window:-all}!"
+        exit 1
+    elif [ $(echo "$ranges" | grep -c .) -eq 1 ]; then
+        # A single member is rendered in place
+        set -- $ranges
+        ARGUMENTS="$ARGUMENTS --offset $4 --clip $3"
+    elif [ -n "$ranges" ]; then
+        # The payloads of the segments are joined, with zero samples in place of the time between them: as long as
+        # the gap, but at least one and at most 16 rows of the waterfall
+        window_file=$OUT_FOLDER/waterfall_window.cs16
+        mkdir -p $OUT_FOLDER
+        echo "$ranges" | while read segment sample_offset sample_count byte_offset gap_samples; do
+            if [ $gap_samples -gt 0 ]; then
+                marker=$(($gap_samples < $FFT ? $FFT : ($gap_samples > 16 * $FFT ? 16 * $FFT : $gap_samples)))
+                echo "## Gap of $gap_samples samples before segment $segment, marked with $marker zero samples" >&2
+                head -c $(($marker * 4)) /dev/zero
+            fi
+            $EXP_PATH/helper/read_range.sh "$recording_slot" $sample_offset $sample_count $segment
+        done > $window_file
+        INPUT=$window_file
+    fi
+fi
+echo "$BINARY_PATH/renderfall $INPUT $ARGUMENTS"
 
 export LD_PRELOAD=$LIB_PATH/libfftw3.so.3
-$BINARY_PATH/renderfall $ARGUMENTS --verbose
+$BINARY_PATH/renderfall $INPUT $ARGUMENTS --verbose
+if [ -n "$window_file" ]; then
+    rm -f $window_file
+fi
 
 if [[ $waterfall_convert_to_jpg == true ]]; then
     echo "### Converting to JPG"